@@ -0,0 +1,195 @@
+/*!
+ * \file      batch_log.cpp
+ * \brief     Append-only segment files written with group commit
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "batch_log.hpp"
+#include "clock.hpp"
+#include "crc32.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+//--> Segment layout
+#define BATCH_LOG_MAGIC         "INGSTLOG"
+#define BATCH_LOG_MAGIC_SIZE    8
+#define BATCH_LOG_RECORD_HEAD   8           // length, crc
+
+//--> Little-endian helper
+static void putU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+
+//--> Constructor, new segments are numbered after the ones a previous run left behind
+BatchLog::BatchLog(const BatchLogOptions& opts) : options(opts) {
+    if (options.segmentSize < 4096) throw std::runtime_error("batch log segment size too small");
+    mkdir(options.directory.c_str(), 0755);
+
+    DIR* dir = opendir(options.directory.c_str());
+    if (!dir) throw std::runtime_error("cannot open batch log directory: " + options.directory);
+    uint64_t last = 0;
+    while (dirent* entry = readdir(dir)) {
+        unsigned long long number;
+        if (std::sscanf(entry->d_name, "ingest-%llu.log", &number) == 1) last = std::max<uint64_t>(last, number);
+    }
+    closedir(dir);
+    producerSegment = last + 1;
+
+    writer = std::thread(&BatchLog::run, this);
+}
+
+//--> Destructor
+BatchLog::~BatchLog() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        running = false;
+    }
+    changed.notify_all();
+    writer.join();
+    if (fd >= 0) close(fd);
+}
+
+//--> Path of segment n
+std::string BatchLog::segmentPath(uint64_t number) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "ingest-%06llu.log", static_cast<unsigned long long>(number));
+    return options.directory + "/" + name;
+}
+
+//--> Swap the batch in, the segment it lands in is decided here so the producer knows it right away
+void BatchLog::commit(std::vector<uint8_t>& batch) {
+    if (batch.empty()) return;
+
+    std::unique_lock<std::mutex> guard(lock);
+    if (waiting.load(std::memory_order_relaxed)) {
+        stats.stalls++;
+        changed.wait(guard, [this] { return !waiting.load(std::memory_order_relaxed); });
+    }
+
+    pendingSegment = producerBytes == 0 ? producerSegment : 0;
+    producerBytes += BATCH_LOG_RECORD_HEAD + batch.size();
+    if (producerBytes >= options.segmentSize) {
+        producerSegment++;
+        producerBytes = 0;
+    }
+
+    pending.swap(batch);
+    batch.clear();
+    waiting.store(true, std::memory_order_release);
+    guard.unlock();
+    changed.notify_all();
+}
+
+//--> Wait for the writer to catch up
+void BatchLog::flush() {
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] { return !waiting.load(std::memory_order_relaxed) && !writing; });
+}
+
+//--> Current counters
+BatchLogMetrics BatchLog::metrics() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
+
+//--> Writer thread, takes the waiting batch and writes it outside the lock
+void BatchLog::run() {
+    std::vector<uint8_t> batch;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        changed.wait(guard, [this] { return waiting.load(std::memory_order_relaxed) || !running; });
+        if (!waiting.load(std::memory_order_relaxed)) break;
+
+        //--> Take the batch, the producer can hand over the next one while this one is written
+        batch.swap(pending);
+        uint64_t segment = pendingSegment;
+        writing = true;
+        waiting.store(false, std::memory_order_release);
+        guard.unlock();
+        changed.notify_all();
+
+        //--> A new segment, or the one whose open failed before
+        bool opened = false;
+        if (segment) opened = openSegment(segment);
+        else if (fd < 0 && openNumber) opened = openSegment(openNumber);
+        int64_t start = monotonicNs();
+        bool ok = write(batch);
+        int64_t tookUs = (monotonicNs() - start) / 1000;
+        size_t bytes = BATCH_LOG_RECORD_HEAD + batch.size();
+        batch.clear();
+
+        guard.lock();
+        writing = false;
+        if (ok) {
+            stats.commits++;
+            stats.bytes += bytes;
+        } else {
+            stats.failed++;
+        }
+        if (opened) stats.segments++;
+        stats.lastCommitUs = tookUs;
+        stats.maxCommitUs = std::max(stats.maxCommitUs, tookUs);
+        changed.notify_all();
+    }
+}
+
+//--> Close the current segment and start a new one, the directory is synced so the new name survives a power cut
+bool BatchLog::openSegment(uint64_t number) {
+    if (fd >= 0) close(fd);
+    openNumber = number;
+    std::string path = segmentPath(number);
+    fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) {
+        std::perror(("cannot open batch log segment " + path).c_str());
+        return false;
+    }
+    if (::write(fd, BATCH_LOG_MAGIC, BATCH_LOG_MAGIC_SIZE) != BATCH_LOG_MAGIC_SIZE) {
+        //--> Without its magic no reader accepts the file, start it over on the next commit
+        std::perror("batch log magic");
+        close(fd);
+        fd = -1;
+        return false;
+    }
+    fileBytes = BATCH_LOG_MAGIC_SIZE;
+
+    if (options.sync) {
+        int dirFd = open(options.directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+    }
+    return true;
+}
+
+//--> One record: header and data in one write, then one sync for all of it, false when the batch is lost
+bool BatchLog::write(const std::vector<uint8_t>& batch) {
+    if (fd < 0) return false;
+
+    uint8_t head[BATCH_LOG_RECORD_HEAD];
+    putU32(head, static_cast<uint32_t>(batch.size()));
+    putU32(head + 4, crc32(batch.data(), batch.size()));
+
+    iovec parts[2] = { {head, sizeof(head)}, {const_cast<uint8_t*>(batch.data()), batch.size()} };
+    size_t total = sizeof(head) + batch.size();
+    ssize_t written = writev(fd, parts, 2);
+    if (written < 0 || static_cast<size_t>(written) != total) {
+        //--> Short write (disk full): cut the torn record off so later commits stay readable
+        std::perror("batch log write");
+        if (written > 0 && ftruncate(fd, static_cast<off_t>(fileBytes)) != 0) std::perror("batch log truncate");
+        return false;
+    }
+    fileBytes += total;
+    if (options.sync && fdatasync(fd) != 0) {
+        std::perror("batch log sync");
+        return false;
+    }
+    return true;
+}
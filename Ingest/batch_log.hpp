@@ -0,0 +1,119 @@
+/*!
+ * \file      batch_log.hpp
+ * \brief     Append-only segment files written with group commit
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * The caller fills a buffer with whatever arrived since the last commit and
+ * hands it over with commit(). A writer thread appends it to the current
+ * segment file (ingest-000001.log, ...) with one write() and one fdatasync(),
+ * so the price of a sync is shared by every message in the batch. While a
+ * sync runs the caller keeps filling the next buffer: the slower the disk,
+ * the bigger the batches, instead of the messages waiting in line.
+ *
+ * A segment starts with the 8 byte magic "INGSTLOG", followed by one record
+ * per commit:
+ *
+ *   u32 length of the data | u32 crc32 of the data | data
+ *
+ * A reader stops at the first record with a bad length or crc, so a commit
+ * torn by a power cut is dropped as a whole. Every run starts a new segment,
+ * a segment is closed when it grows past segmentSize.
+ *
+ * A batch that cannot be written (segment open failed, short write) is
+ * counted as failed, not as a commit. After a failed open the next commit
+ * tries to open the segment again.
+ *
+ */
+
+#ifndef BATCH_LOG_HPP
+#define BATCH_LOG_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//--> Log settings
+struct BatchLogOptions {
+    std::string directory = "ingest";
+    size_t segmentSize = 64 * 1024 * 1024;          // bytes after which the next commit starts a new file
+    bool sync = true;                               // fdatasync every commit, off only for benchmarks
+};
+
+//--> Log counters
+struct BatchLogMetrics {
+    uint64_t commits;           // batches written and synced
+    uint64_t failed;            // batches lost: no segment could be opened or the write was short
+    uint64_t bytes;             // bytes written, record headers included
+    uint64_t stalls;            // commit() had to wait for the previous batch
+    uint64_t segments;          // segment files started
+    int64_t lastCommitUs;       // write + sync time of the last batch
+    int64_t maxCommitUs;
+};
+
+//--> Group commit writer, one producer thread
+class BatchLog {
+
+//-> Public functions
+public:
+    //--> Constructor, creates the directory and starts the writer thread (throws std::runtime_error)
+    explicit BatchLog(const BatchLogOptions& options);
+
+    //--> Destructor, writes what was handed over and stops the thread
+    ~BatchLog();
+
+    BatchLog(const BatchLog&) = delete;
+    BatchLog& operator=(const BatchLog&) = delete;
+
+    //--> True when the writer has nothing waiting, a commit() now does not block
+    bool idle() const { return !waiting.load(std::memory_order_acquire); }
+
+    //--> Hand the batch to the writer, batch comes back empty, blocks while the previous batch still waits
+    void commit(std::vector<uint8_t>& batch);
+
+    //--> Wait until everything handed over is written and synced
+    void flush();
+
+    //--> Segment the next commit goes to, changes when a segment is full (producer side)
+    uint64_t segment() const { return producerSegment; }
+
+    //--> Current counters
+    BatchLogMetrics metrics();
+
+//-> Private functions and variables
+private:
+    BatchLogOptions options;
+    std::thread writer;
+    std::mutex lock;
+    std::condition_variable changed;
+    std::atomic<bool> waiting{false};   // pending holds a batch
+    bool writing = false;               // the writer has a batch out of the lock
+    bool running = true;
+
+    //--> Batch waiting for the writer, and the segment it starts (0 = append to the current one)
+    std::vector<uint8_t> pending;
+    uint64_t pendingSegment = 0;
+
+    //--> Producer side bookkeeping
+    uint64_t producerSegment;
+    size_t producerBytes = 0;
+
+    //--> Writer side
+    int fd = -1;
+    uint64_t openNumber = 0;            // segment the writer appends to, opened again while fd is -1
+    size_t fileBytes = 0;
+    BatchLogMetrics stats{};
+
+    std::string segmentPath(uint64_t number) const;
+    void run();
+    bool openSegment(uint64_t number);
+    bool write(const std::vector<uint8_t>& batch);
+};
+
+#endif //--> BATCH_LOG_HPP
@@ -0,0 +1,181 @@
+/*!
+ * \file      bench_ingest.cpp
+ * \brief     Throughput of the ingestion service in messages per second per core
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Feeds the payloads of DEVICES simulated devices, round robin, through the
+ * stages of the service:
+ *
+ *   parse       JsonReader / decodeTelemetry only
+ *   ingest      Ingestor: device lookup, parse, grouping, batch log without sync
+ *   + sync      the same with fdatasync on every commit (group commit)
+ *   loopback    + sync, messages arrive on the delivery thread of a
+ *               LoopbackTransport like they would from paho
+ *
+ * for three kinds of payload: one Opdracht_5 JSON sample per message, a
+ * batch of 20 of them ({"samples":[...]}), and a binary vitals record.
+ * Per core is messages divided by the CPU time of the whole process (all
+ * threads, including the writer), so it stays honest when the writer thread
+ * runs on another core.
+ *
+ * command used to compile:  g++ -O2 -std=c++17 bench_ingest.cpp ingest.cpp batch_log.cpp ../common/telemetry_codec.cpp ../common/loopback_transport.cpp -I../common -o bench_ingest -pthread  then to run: ./bench_ingest
+ */
+
+#include "clock.hpp"
+#include "ingest.hpp"
+#include "json_reader.hpp"
+#include "json_writer.hpp"
+#include "loopback_transport.hpp"
+#include "telemetry_codec.hpp"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+//--> Same records as Opdracht_5 and PROG6
+inline constexpr JsonField SENSOR_FIELDS[] = {
+    {"seq", 0}, {"ts_us", 0}, {"temperature", 2}, {"humidity", 2}, {"pressure", 2}
+};
+
+const size_t DEVICES = 5000;
+const size_t MESSAGES = 1000000;
+const size_t BATCH_SAMPLES = 20;
+const std::string DIRECTORY{"bench_ingest.tmp"};
+
+//--> Keeps the compiler from optimising the work away
+static std::atomic<size_t> sink{0};
+
+//--> One message of the benchmark
+struct Message {
+    std::string topic;
+    std::string payload;
+};
+
+//--> Payload kinds
+enum class Kind { Json, JsonBatch, Binary };
+
+//--> One payload per device
+static std::vector<Message> makeMessages(Kind kind) {
+    std::vector<Message> messages;
+    JsonWriter<256> json;
+    int64_t timestampUs = wallMicros(monotonicNs());
+    for (size_t i = 0; i < DEVICES; i++) {
+        char topic[48];
+        float t = 20.0f + (i % 50) * 0.1f, h = 45.0f + (i % 20), p = 1013.25f;
+        if (kind == Kind::Binary) {
+            std::snprintf(topic, sizeof(topic), "ward/bed-%04zu/current/bin", i);
+            const float values[5] = { 72.0f + (i % 30), 120.0f, 98.0f, 16.0f, 36.8f };
+            uint8_t record[TELEMETRY_HEADER_SIZE + 5 * 4];
+            size_t size = encodeTelemetry(record, sizeof(record), TelemetryType::Vitals, static_cast<uint32_t>(i), timestampUs, values, 5);
+            messages.push_back({topic, std::string(reinterpret_cast<const char*>(record), size)});
+        } else if (kind == Kind::Json) {
+            std::snprintf(topic, sizeof(topic), "site-%04zu/school", i);
+            messages.push_back({topic, std::string(json.record<SENSOR_FIELDS>(i, timestampUs, t, h, p))});
+        } else {
+            std::snprintf(topic, sizeof(topic), "site-%04zu/school", i);
+            std::string payload = "{\"samples\":[";
+            for (size_t s = 0; s < BATCH_SAMPLES; s++) {
+                if (s) payload += ',';
+                payload += json.record<SENSOR_FIELDS>(i * BATCH_SAMPLES + s, timestampUs + s * 50000, t, h, p);
+            }
+            payload += "]}";
+            messages.push_back({topic, payload});
+        }
+    }
+    return messages;
+}
+
+//--> CPU time of all threads of the process in ns
+static int64_t processCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//--> Remove the segment files of a run
+static void removeSegments() {
+    if (DIR* dir = opendir(DIRECTORY.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') unlink((DIRECTORY + "/" + entry->d_name).c_str());
+        }
+        closedir(dir);
+    }
+    rmdir(DIRECTORY.c_str());
+}
+
+//--> Run one stage and print messages per second, wall clock and per core
+template <typename Step, typename Done>
+static void measure(const char* name, const std::vector<Message>& messages, size_t rowsPerMessage, Step step, Done done) {
+    int64_t wallStart = monotonicNs();
+    int64_t cpuStart = processCpuNs();
+    for (size_t i = 0; i < MESSAGES; i++) step(messages[i % messages.size()]);
+    done();
+    double wallS = (monotonicNs() - wallStart) / 1e9;
+    double cpuS = (processCpuNs() - cpuStart) / 1e9;
+    std::printf("  %-10s %7.2f M msg/s, %7.2f M msg/s per core, %7.2f M rows/s per core\n", name,
+                MESSAGES / wallS / 1e6, MESSAGES / cpuS / 1e6, MESSAGES * rowsPerMessage / cpuS / 1e6);
+}
+
+//--> All stages for one kind of payload
+static void run(Kind kind, const char* name) {
+    std::vector<Message> messages = makeMessages(kind);
+    size_t rowsPerMessage = kind == Kind::JsonBatch ? BATCH_SAMPLES : 1;
+    std::printf("%s, %zu devices, %zu messages of %zu bytes\n", name, DEVICES, MESSAGES, messages[0].payload.size());
+
+    //--> Parsing alone
+    measure("parse", messages, rowsPerMessage, [kind](const Message& m) {
+        if (kind == Kind::Binary) {
+            TelemetryRecord record;
+            size_t used;
+            if (decodeTelemetry(reinterpret_cast<const uint8_t*>(m.payload.data()), m.payload.size(), record, used)) sink += record.count;
+        } else {
+            JsonReader reader(m.payload);
+            JsonRecord record;
+            while (reader.next(record)) sink += record.count;
+        }
+    }, [] {});
+
+    //--> The whole service on this thread, writer thread without and with sync
+    for (bool sync : {false, true}) {
+        removeSegments();
+        IngestOptions options;
+        options.log.directory = DIRECTORY;
+        options.log.sync = sync;
+        Ingestor ingestor(options);
+        measure(sync ? "+ sync" : "ingest", messages, rowsPerMessage,
+                [&](const Message& m) { ingestor.receive(m.topic, m.payload); }, [&] { ingestor.flush(); });
+        IngestMetrics metrics = ingestor.metrics();
+        std::printf("             %llu rows in %llu commits (%llu rows each), %llu stalls, commit max %lld us, %.1f bytes per row\n",
+                    static_cast<unsigned long long>(metrics.rows), static_cast<unsigned long long>(metrics.log.commits),
+                    static_cast<unsigned long long>(metrics.log.commits ? metrics.rows / metrics.log.commits : 0),
+                    static_cast<unsigned long long>(metrics.log.stalls), static_cast<long long>(metrics.log.maxCommitUs),
+                    static_cast<double>(metrics.log.bytes) / metrics.rows);
+    }
+
+    //--> Messages from a transport thread, like from paho
+    removeSegments();
+    IngestOptions options;
+    options.log.directory = DIRECTORY;
+    Ingestor ingestor(options);
+    LoopbackTransport transport(true);
+    transport.attach("#", [&ingestor](std::string_view topic, std::string_view payload) { ingestor.receive(topic, payload); });
+    transport.start();
+    measure("loopback", messages, rowsPerMessage, [&](const Message& m) { transport.publish(m.topic, m.payload, 0); }, [&] {
+        for (LoopbackMetrics lm = transport.metrics(); lm.delivered < lm.published; lm = transport.metrics()) std::this_thread::yield();
+        ingestor.flush();
+    });
+    transport.stop();
+    removeSegments();
+}
+
+int main() {
+    run(Kind::Json, "json");
+    run(Kind::JsonBatch, "json batch");
+    run(Kind::Binary, "binary");
+    return sink == 0;
+}
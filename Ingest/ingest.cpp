@@ -0,0 +1,241 @@
+/*!
+ * \file      ingest.cpp
+ * \brief     Turns incoming telemetry messages into per-device batches in the batch log
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "ingest.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+//--> Block kinds in a commit
+const uint8_t BLOCK_DEVICE = 1;
+const uint8_t BLOCK_ROWS = 2;
+const size_t MAX_BLOCK_ROWS = 65535;
+
+//--> Value names of the binary record types, the same keys the JSON records use
+inline constexpr std::string_view SENSOR_NAMES[] = { "temperature", "humidity", "pressure" };
+inline constexpr std::string_view VITALS_NAMES[] = { "heartbeat", "bloodpressure", "bloodoxygen", "breathspeed", "bodytemperature" };
+
+//--> Name of value i of a binary record, empty when the type has no name for it
+static std::string_view binaryName(TelemetryType type, size_t i) {
+    if (type == TelemetryType::Sensor && i < std::size(SENSOR_NAMES)) return SENSOR_NAMES[i];
+    if (type == TelemetryType::Vitals && i < std::size(VITALS_NAMES)) return VITALS_NAMES[i];
+    return {};
+}
+
+//--> Append raw bytes to a buffer
+template <typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+    size_t at = out.size();
+    out.resize(at + sizeof(T));
+    std::memcpy(out.data() + at, &value, sizeof(T));
+}
+
+//--> Constructor
+Ingestor::Ingestor(const IngestOptions& opts) : options(opts), log(opts.log) {}
+
+//--> Destructor
+Ingestor::~Ingestor() {
+    flush();
+}
+
+//--> One message: find the device, take the rows out of the payload, commit when a batch is full
+void Ingestor::receive(std::string_view topic, std::string_view payload) {
+    std::lock_guard<std::mutex> guard(lock);
+    messages++;
+
+    uint32_t id = device(topic);
+    bool ok = id != UINT32_MAX &&
+              (isBinaryTelemetry(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()) ? receiveBinary(id, payload)
+                                                                                                   : receiveJson(id, payload));
+    if (!ok) rejected++;
+
+    //--> A full batch goes when the log is free, past the hard limit it waits for the disk
+    if ((pendingRows >= options.batchRows && log.idle()) || pendingRows >= options.maxPendingRows) commit();
+}
+
+//--> Commit on age
+void Ingestor::poll() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (pendingRows == 0 || !log.idle()) return;
+    if (pendingRows >= options.batchRows || monotonicNs() - oldestNs >= std::chrono::nanoseconds(options.maxDelay).count()) commit();
+}
+
+//--> Commit and wait for the sync
+void Ingestor::flush() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (pendingRows) commit();
+    log.flush();
+}
+
+//--> Current counters
+IngestMetrics Ingestor::metrics() {
+    std::lock_guard<std::mutex> guard(lock);
+    return { messages, rows, rejected, skippedFields, devices.size(), pendingRows, log.metrics() };
+}
+
+//--> Device of a topic, /bin and the JSON topic are the same device, UINT32_MAX when the topic cannot be stored
+uint32_t Ingestor::device(std::string_view topic) {
+    if (topic.size() > TELEMETRY_BINARY_SUFFIX.size() &&
+        topic.compare(topic.size() - TELEMETRY_BINARY_SUFFIX.size(), std::string_view::npos, TELEMETRY_BINARY_SUFFIX) == 0) {
+        topic.remove_suffix(TELEMETRY_BINARY_SUFFIX.size());
+    }
+
+    auto found = index.find(topic);
+    if (found != index.end()) return found->second;
+    if (topic.size() > UINT16_MAX) return UINT32_MAX;
+
+    uint32_t id = static_cast<uint32_t>(devices.size());
+    devices.emplace_back();
+    devices.back().topic = std::string(topic);
+    index.emplace(devices.back().topic, id);
+    return id;
+}
+
+//--> JSON, one record or a batch of them
+bool Ingestor::receiveJson(uint32_t id, std::string_view payload) {
+    Device& d = devices[id];
+    JsonReader reader(payload);
+    JsonRecord record;
+    bool any = false;
+
+    while (reader.next(record)) {
+        //--> The first record decides the fields of the device
+        if (!d.hasSchema) {
+            for (size_t i = 0; i < record.count; i++) {
+                if (record.fields[i].key != "seq" && record.fields[i].key != "ts_us") d.fields.emplace_back(record.fields[i].key);
+            }
+            d.hasSchema = true;
+        }
+
+        float values[JSON_MAX_FIELDS];
+        std::fill_n(values, d.fields.size(), std::numeric_limits<float>::quiet_NaN());
+        int64_t timestampUs = -1;
+        uint32_t sequence = 0;
+
+        //--> Fields mostly come in schema order, so try the next slot before searching
+        size_t next = 0;
+        for (size_t i = 0; i < record.count; i++) {
+            const JsonNumber& field = record.fields[i];
+            if (field.key == "ts_us") timestampUs = static_cast<int64_t>(field.value);
+            else if (field.key == "seq") sequence = static_cast<uint32_t>(field.value);
+            else {
+                size_t slot = next < d.fields.size() && d.fields[next] == field.key
+                              ? next : static_cast<size_t>(std::find(d.fields.begin(), d.fields.end(), field.key) - d.fields.begin());
+                if (slot < d.fields.size()) {
+                    values[slot] = static_cast<float>(field.value);
+                    next = slot + 1;
+                } else {
+                    skippedFields++;
+                }
+            }
+        }
+        skippedFields += record.skipped;
+
+        if (timestampUs < 0) timestampUs = wallMicros(monotonicNs());
+        addRow(id, timestampUs, sequence, values);
+        any = true;
+    }
+    return any && !reader.failed();
+}
+
+//--> Binary records back to back
+bool Ingestor::receiveBinary(uint32_t id, std::string_view payload) {
+    Device& d = devices[id];
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(payload.data());
+    size_t left = payload.size();
+    bool any = false;
+
+    while (left > 0) {
+        TelemetryRecord record;
+        size_t used;
+        if (!decodeTelemetry(data, left, record, used) || binaryName(record.type, 0).empty()) return false;
+        data += used;
+        left -= used;
+
+        if (!d.hasSchema) {
+            for (size_t i = 0; i < record.count && !binaryName(record.type, i).empty(); i++) d.fields.emplace_back(binaryName(record.type, i));
+            d.hasSchema = true;
+        }
+
+        float values[JSON_MAX_FIELDS];          // the schema may come from a JSON record
+        std::fill_n(values, d.fields.size(), std::numeric_limits<float>::quiet_NaN());
+        for (size_t i = 0; i < record.count; i++) {
+            std::string_view name = binaryName(record.type, i);
+            size_t slot = i < d.fields.size() && d.fields[i] == name
+                          ? i : static_cast<size_t>(std::find(d.fields.begin(), d.fields.end(), name) - d.fields.begin());
+            if (!name.empty() && slot < d.fields.size()) values[slot] = static_cast<float>(record.value(i));
+            else skippedFields++;
+        }
+
+        addRow(id, record.timestampUs, record.sequence, values);
+        any = true;
+    }
+    return any;
+}
+
+//--> Append one packed row to the device
+void Ingestor::addRow(uint32_t id, int64_t timestampUs, uint32_t sequence, const float* values) {
+    Device& d = devices[id];
+    if (!d.dirty) {
+        d.dirty = true;
+        dirtyDevices.push_back(id);
+    }
+    if (pendingRows == 0) oldestNs = monotonicNs();
+
+    size_t at = d.rows.size();
+    d.rows.resize(at + d.rowSize());
+    uint8_t* row = d.rows.data() + at;
+    std::memcpy(row, &timestampUs, 8);
+    std::memcpy(row + 8, &sequence, 4);
+    std::memcpy(row + 12, values, 4 * d.fields.size());
+
+    pendingRows++;
+    rows++;
+}
+
+//--> One block list for all devices with rows, the definitions first where this segment does not have them yet
+void Ingestor::commit() {
+    uint64_t segment = log.segment();
+    batch.clear();
+
+    for (uint32_t id : dirtyDevices) {
+        Device& d = devices[id];
+        if (d.definedIn != segment) {
+            put<uint8_t>(batch, BLOCK_DEVICE);
+            put<uint32_t>(batch, id);
+            put<uint16_t>(batch, static_cast<uint16_t>(d.topic.size()));
+            batch.insert(batch.end(), d.topic.begin(), d.topic.end());
+            put<uint8_t>(batch, static_cast<uint8_t>(d.fields.size()));
+            for (const std::string& field : d.fields) {
+                size_t length = std::min<size_t>(field.size(), UINT8_MAX);
+                put<uint8_t>(batch, static_cast<uint8_t>(length));
+                batch.insert(batch.end(), field.begin(), field.begin() + length);
+            }
+            d.definedIn = segment;
+        }
+
+        size_t rowSize = d.rowSize();
+        size_t count = d.rows.size() / rowSize;
+        for (size_t first = 0; first < count; first += MAX_BLOCK_ROWS) {
+            size_t n = std::min(count - first, MAX_BLOCK_ROWS);
+            put<uint8_t>(batch, BLOCK_ROWS);
+            put<uint32_t>(batch, id);
+            put<uint16_t>(batch, static_cast<uint16_t>(n));
+            put<uint8_t>(batch, static_cast<uint8_t>(d.fields.size()));
+            batch.insert(batch.end(), d.rows.begin() + first * rowSize, d.rows.begin() + (first + n) * rowSize);
+        }
+        d.rows.clear();
+        d.dirty = false;
+    }
+
+    dirtyDevices.clear();
+    pendingRows = 0;
+    log.commit(batch);
+}
@@ -0,0 +1,142 @@
+/*!
+ * \file      ingest.hpp
+ * \brief     Turns incoming telemetry messages into per-device batches in the batch log
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Accepts every payload the publishers in this repository send:
+ *
+ *   JSON     {"seq":..,"ts_us":..,"temperature":..}, one record per message
+ *   batched  {"samples":[{...},{...}]} from common/batch_publisher
+ *   binary   records back to back on <topic>/bin, common/telemetry_codec
+ *
+ * A device is its topic without the /bin suffix, so "school" and
+ * "school/bin" are the same device and "ward/bed-001/current" is one bed.
+ * JSON is read with common/json_reader.hpp, the topic is looked up in a
+ * hash map keyed by string_views into the device table, so a message from a
+ * known device allocates nothing.
+ *
+ * Rows are collected per device. When batchRows rows are waiting, or the
+ * oldest is maxDelay old, all devices with rows are packed into one buffer
+ * and handed to the BatchLog (group commit). The data of one commit is a
+ * list of blocks, integers little-endian (host order on the Pi and x86):
+ *
+ *   u8 1 device  | u32 device | u16 topic length | topic | u8 fields | per field: u8 length | name
+ *   u8 2 rows    | u32 device | u16 rows | u8 fields | rows of: i64 ts_us | u32 seq | f32 per field
+ *
+ * Device ids are only valid within a segment file: a device is defined
+ * again in the first commit of every segment it appears in, so every
+ * segment can be read on its own. The fields of a device are the numeric
+ * keys of its first record, minus seq and ts_us, a missing value is NaN.
+ *
+ * A commit is durable once BatchLog has synced it. Messages received as
+ * QoS 1 are acknowledged by paho when the handler returns, so a crash can
+ * lose at most the rows of the last maxDelay.
+ *
+ */
+
+#ifndef INGEST_HPP
+#define INGEST_HPP
+
+#include "batch_log.hpp"
+#include "json_reader.hpp"
+#include "telemetry_codec.hpp"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+//--> Ingest settings
+struct IngestOptions {
+    BatchLogOptions log;
+    size_t batchRows = 4096;                        // commit when this many rows wait
+    std::chrono::milliseconds maxDelay{100};        // or when the oldest row waited this long
+    size_t maxPendingRows = 262144;                 // past this receive() waits for the disk
+};
+
+//--> Ingest counters
+struct IngestMetrics {
+    uint64_t messages;          // payloads received
+    uint64_t rows;              // records taken from them
+    uint64_t rejected;          // payloads that were not valid JSON or binary records
+    uint64_t skippedFields;     // values outside the schema of the device, or not a number
+    size_t devices;             // devices seen
+    size_t pendingRows;         // rows not yet handed to the log
+    BatchLogMetrics log;
+};
+
+//--> Message in, rows out, thread safe but meant for one receiving thread
+class Ingestor {
+
+//-> Public functions
+public:
+    //--> Constructor, opens the batch log (throws std::runtime_error)
+    explicit Ingestor(const IngestOptions& options);
+
+    //--> Destructor, commits what is still waiting
+    ~Ingestor();
+
+    //--> One message from the transport
+    void receive(std::string_view topic, std::string_view payload);
+
+    //--> Commit rows that waited maxDelay, call this regularly when messages can stop coming
+    void poll();
+
+    //--> Commit everything and wait until it is on disk
+    void flush();
+
+    //--> Current counters
+    IngestMetrics metrics();
+
+//-> Private functions and variables
+private:
+    //--> One device and the rows it has waiting
+    struct Device {
+        std::string topic;
+        std::vector<std::string> fields;
+        std::vector<uint8_t> rows;          // packed rows, rowSize() bytes each
+        uint64_t definedIn = 0;             // segment that holds the definition block
+        bool hasSchema = false;             // fields are set by the first record
+        bool dirty = false;                 // in dirtyDevices
+
+        size_t rowSize() const { return 12 + 4 * fields.size(); }
+    };
+
+    IngestOptions options;
+    BatchLog log;
+    std::mutex lock;
+
+    //--> Devices by id, deque so the topic strings the index points into never move
+    std::deque<Device> devices;
+    std::unordered_map<std::string_view, uint32_t> index;
+
+    //--> Rows waiting for the next commit
+    std::vector<uint32_t> dirtyDevices;
+    size_t pendingRows = 0;
+    int64_t oldestNs = 0;
+    std::vector<uint8_t> batch;
+
+    //--> Counters
+    uint64_t messages = 0;
+    uint64_t rows = 0;
+    uint64_t rejected = 0;
+    uint64_t skippedFields = 0;
+
+    //--> Find or create the device of a topic
+    uint32_t device(std::string_view topic);
+
+    //--> Payload parsing, add rows to a device
+    bool receiveJson(uint32_t id, std::string_view payload);
+    bool receiveBinary(uint32_t id, std::string_view payload);
+    void addRow(uint32_t id, int64_t timestampUs, uint32_t sequence, const float* values);
+
+    //--> Pack the waiting rows of all devices and hand them to the log
+    void commit();
+};
+
+#endif //--> INGEST_HPP
@@ -0,0 +1,133 @@
+/*!
+ * \file      main.cpp
+ * \brief     Main entry point for the telemetry ingestion service, stores what the sensors and monitors publish
+ * \author    Wietse Houwers
+ * \date      October 2026
+ */
+
+
+/*
+* the other side of the pipeline: one subscriber that stores the records of every device that publishes.
+*
+* it subscribes to the topics of Opdracht_5 (school, school/bin), the PROG6 monitor (current, current/bin) and the ward (ward/+/current, ward/+/current/bin), or to the filters given with --topics.
+* every message goes through the Ingestor (ingest.hpp): the payload is parsed without copies, the rows are grouped per device (the topic without /bin) and written in batches to segment files in ./ingest with group commit (batch_log.hpp), one write and one fdatasync for thousands of messages.
+* every STATUS_EVERY the message rate, the number of devices and the commit sizes and times are printed. Ctrl-C commits what is waiting before the program stops.
+*
+* bench_ingest.cpp measures how many messages per second one core can take, with and without the sync.
+*
+* command used to compile:  g++ -O2 main.cpp ingest.cpp batch_log.cpp ../common/telemetry_codec.cpp ../common/connection_manager.cpp ../common/paho_transport.cpp ../common/inflight_publisher.cpp ../common/spool.cpp ../common/topic_aliases.cpp -I../common -o ingest -lpaho-mqttpp3 -lpaho-mqtt3as -pthread
+* then to run: ./ingest [--topics a,b,c] [--dir ingest] [--batch 4096] [--delay-ms 100]
+*/
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mqtt/async_client.h>
+#include "ingest.hpp"
+#include "paho_transport.hpp"
+
+//--> mqtt setup
+const std::string SERVER_ADDRESS{"tcp://192.168.50.95:1883"};   // change to "tcp://127.0.0.1:1883" when using local broker
+const std::string CLIENT_ID{"WIETSE-INGEST"};
+const int QOS = 1;
+
+//--> mqtt authentication
+const std::string MQTT_USERNAME{"school"};
+const std::string MQTT_PASSWORD{"Han@2025!"};
+
+//--> telemetry topics of the publishers in this repository
+const char* DEFAULT_TOPICS = "school,school/bin,current,current/bin,ward/+/current,ward/+/current/bin";
+
+//--> loop timing, poll() commits rows that waited maxDelay
+const auto POLL_PERIOD = std::chrono::milliseconds(10);
+const auto STATUS_EVERY = std::chrono::seconds(5);
+
+//--> set by Ctrl-C
+static std::atomic<bool> stopping{false};
+
+//--> Split a comma separated list
+static std::vector<std::string> splitList(const std::string& text) {
+    std::vector<std::string> items;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find(',', start);
+        if (end == std::string::npos) end = text.size();
+        if (end > start) items.push_back(text.substr(start, end - start));
+        start = end + 1;
+    }
+    return items;
+}
+
+int main(int argc, char* argv[]) {
+    // settings from the command line
+    IngestOptions options;
+    std::string topics = DEFAULT_TOPICS;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--topics") == 0 && i + 1 < argc) topics = argv[++i];
+        else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc) options.log.directory = argv[++i];
+        else if (std::strcmp(argv[i], "--batch") == 0 && i + 1 < argc) options.batchRows = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--delay-ms") == 0 && i + 1 < argc) options.maxDelay = std::chrono::milliseconds(std::atol(argv[++i]));
+    }
+
+    // storage first, a directory that cannot be written stops the program before it connects
+    std::unique_ptr<Ingestor> ingestor;
+    try {
+        ingestor = std::make_unique<Ingestor>(options);
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    // --> SETUP
+    mqtt::async_client client(SERVER_ADDRESS, CLIENT_ID);
+    mqtt::connect_options connOpts;
+    connOpts.set_user_name(MQTT_USERNAME);
+    connOpts.set_password(MQTT_PASSWORD);
+
+    // Connection manager inside the transport keeps the connection up, the session is persistent so QoS1 messages sent while we were away still arrive
+    PahoTransport transport(client, connOpts);
+    for (const std::string& filter : splitList(topics)) {
+        transport.subscribe(filter, QOS);
+        std::cout << "subscribed to " << filter << std::endl;
+    }
+    transport.setMessageHandler([&ingestor](std::string_view topic, std::string_view payload) { ingestor->receive(topic, payload); });
+    transport.start();
+
+    std::signal(SIGINT, [](int) { stopping = true; });
+    std::signal(SIGTERM, [](int) { stopping = true; });
+
+    // --> MAIN LOOP
+    auto nextStatus = std::chrono::steady_clock::now() + STATUS_EVERY;
+    uint64_t lastMessages = 0;
+    while (!stopping) {
+        std::this_thread::sleep_for(POLL_PERIOD);
+        ingestor->poll();
+
+        if (std::chrono::steady_clock::now() < nextStatus) continue;
+        nextStatus += STATUS_EVERY;
+        IngestMetrics m = ingestor->metrics();
+        double rate = static_cast<double>(m.messages - lastMessages) / std::chrono::duration<double>(STATUS_EVERY).count();
+        lastMessages = m.messages;
+        std::cout << "ingest " << connectionStateName(transport.state()) << ": " << rate << " msg/s, " << m.devices << " devices, "
+                  << m.rows << " rows, " << m.rejected << " rejected, " << m.log.commits << " commits ("
+                  << (m.log.commits + m.log.failed ? (m.rows - m.pendingRows) / (m.log.commits + m.log.failed) : 0) << " rows each), "
+                  << m.log.failed << " failed, commit " << m.log.lastCommitUs << " us (max " << m.log.maxCommitUs << "), "
+                  << m.log.stalls << " stalls" << std::endl;
+    }
+
+    // commit what is still waiting
+    transport.stop();
+    ingestor->flush();
+    IngestMetrics m = ingestor->metrics();
+    std::cout << "stopped: " << m.rows << " rows of " << m.devices << " devices in " << m.log.commits << " commits, "
+              << m.log.bytes << " bytes, " << m.log.failed << " failed commits" << std::endl;
+    return 0;
+}
@@ -0,0 +1,281 @@
+/*!
+ * \file      bench_latency.cpp
+ * \brief     End-to-end latency of the sensor publish path, acquisition to subscriber
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Publishes samples the same way main.cpp does (JsonWriter or binary record,
+ * in-flight publisher) and subscribes to the same topic with a second client
+ * in this process, so both ends use the same clock. Every sample is stamped
+ * at acquisition (ts_us in the payload), again when it is handed to the mqtt
+ * client, and once more when the subscriber receives it. The three stages
+ * are kept in HDR histograms (common/hdr_histogram.hpp):
+ *
+ *   acquire -> publish    formatting and handing the message to paho
+ *   publish -> receive    client, broker and back
+ *   acquire -> receive    the whole path
+ *
+ * With --sensor the acquisition is a real BME280 burst read over I2C,
+ * otherwise a clock read with made-up values. Run against a local broker
+ * (mosquitto on 127.0.0.1) to leave the network out, or against the real one
+ * to include it. Rates and formats take a comma separated list, every
+ * combination is one run and one line in the report.
+ *
+ * command used to compile:  g++ -O2 bench_latency.cpp realtime.cpp ../common/inflight_publisher.cpp ../common/spool.cpp ../common/topic_aliases.cpp ../common/telemetry_codec.cpp ../common/hdr_histogram.cpp bme280.cpp i2c.cpp -I../common -o bench_latency -lpaho-mqttpp3 -lpaho-mqtt3as -pthread
+ * then to run: ./bench_latency [--broker tcp://127.0.0.1:1883] [--rates 10,100,1000] [--formats json,binary] [--qos 0|1] [--seconds 10] [--sensor]
+ */
+
+#include "bme280.hpp"
+#include "realtime.hpp"
+#include "clock.hpp"
+#include "hdr_histogram.hpp"
+#include "inflight_publisher.hpp"
+#include "json_writer.hpp"
+#include "telemetry_codec.hpp"
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <mqtt/async_client.h>
+
+//--> Defaults, a local broker so the network is not part of the numbers
+const std::string DEFAULT_BROKER{"tcp://127.0.0.1:1883"};
+const std::string TOPIC{"bench/latency"};
+const size_t MAX_IN_FLIGHT = 1024;
+const size_t PUBLISH_RING = 1 << 16;                    // publish stamps by sequence number
+const auto DRAIN_TIME = std::chrono::seconds(2);        // wait for the last messages after a run
+
+//--> Same payload as the sensor topic
+inline constexpr JsonField SENSOR_FIELDS[] = {
+    {"seq", 0}, {"ts_us", 0}, {"temperature", 2}, {"humidity", 2}, {"pressure", 2}
+};
+
+//--> Command line settings
+struct BenchOptions {
+    std::string broker = DEFAULT_BROKER;
+    std::vector<double> rates = {10.0, 100.0, 1000.0};
+    std::vector<PayloadFormat> formats = {PayloadFormat::Json, PayloadFormat::Binary};
+    int qos = 0;
+    int seconds = 10;
+    bool sensor = false;
+};
+
+//--> Results of one run, the receive side is written by the subscriber thread only
+struct Stages {
+    HdrHistogram acquireToPublish;
+    HdrHistogram publishToReceive;
+    HdrHistogram acquireToReceive;
+    uint64_t sent = 0;
+    std::atomic<uint64_t> received{0};
+    std::atomic<uint64_t> unreadable{0};
+};
+
+//--> Handed-off time per sequence number, written by the sampler, read by the subscriber
+std::vector<std::atomic<int64_t>> publishedUs(PUBLISH_RING);
+
+//--> Number after "key": in a JSON record
+static bool jsonNumber(std::string_view json, std::string_view key, int64_t& value) {
+    size_t at = json.find(key);
+    if (at == std::string_view::npos) return false;
+    const char* begin = json.data() + at + key.size();
+    return std::from_chars(begin, json.data() + json.size(), value).ec == std::errc();
+}
+
+//--> Subscriber side, stamps the arrival and fills the receive histograms
+class Receiver : public virtual mqtt::callback {
+public:
+    //--> Count into this run, stop() returns once no message is being counted any more
+    void start(Stages* run) {
+        std::lock_guard<std::mutex> lock(mutex);
+        stages = run;
+    }
+    void stop() {
+        std::lock_guard<std::mutex> lock(mutex);
+        stages = nullptr;
+    }
+
+    void message_arrived(mqtt::const_message_ptr msg) override {
+        int64_t receivedUs = wallMicros(monotonicNs());
+        std::lock_guard<std::mutex> lock(mutex);
+        Stages* s = stages;
+        if (!s || !msg) return;
+
+        //--> Sequence and acquisition time from the payload itself
+        const std::string& payload = msg->get_payload_str();
+        int64_t seq = 0, acquiredUs = 0;
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(payload.data());
+        if (isBinaryTelemetry(data, payload.size())) {
+            TelemetryRecord record;
+            size_t used;
+            if (!decodeTelemetry(data, payload.size(), record, used)) {
+                s->unreadable++;
+                return;
+            }
+            seq = record.sequence;
+            acquiredUs = record.timestampUs;
+        } else if (!jsonNumber(payload, "\"seq\":", seq) || !jsonNumber(payload, "\"ts_us\":", acquiredUs)) {
+            s->unreadable++;
+            return;
+        }
+
+        s->acquireToReceive.record(receivedUs - acquiredUs);
+        int64_t publishUs = publishedUs[static_cast<size_t>(seq) % PUBLISH_RING].load(std::memory_order_acquire);
+        if (publishUs) s->publishToReceive.record(receivedUs - publishUs);
+        s->received++;
+    }
+
+private:
+    std::mutex mutex;
+    Stages* stages = nullptr;
+};
+
+//--> Comma separated list
+static std::vector<std::string> splitList(const char* text) {
+    std::vector<std::string> items;
+    std::string_view rest = text;
+    while (!rest.empty()) {
+        size_t comma = rest.find(',');
+        items.emplace_back(rest.substr(0, comma));
+        rest.remove_prefix(comma == std::string_view::npos ? rest.size() : comma + 1);
+    }
+    return items;
+}
+
+//--> Read the command line
+static BenchOptions parseOptions(int argc, char* argv[]) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--broker") == 0 && i + 1 < argc) options.broker = argv[++i];
+        else if (std::strcmp(argv[i], "--qos") == 0 && i + 1 < argc) options.qos = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) options.seconds = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--sensor") == 0) options.sensor = true;
+        else if (std::strcmp(argv[i], "--rates") == 0 && i + 1 < argc) {
+            options.rates.clear();
+            for (const std::string& rate : splitList(argv[++i])) options.rates.push_back(std::atof(rate.c_str()));
+        } else if (std::strcmp(argv[i], "--formats") == 0 && i + 1 < argc) {
+            options.formats.clear();
+            for (const std::string& format : splitList(argv[++i])) options.formats.push_back(parsePayloadFormat(format.c_str()));
+        }
+    }
+    return options;
+}
+
+//--> One line of the report
+static void printStage(const char* name, const HdrHistogram& h) {
+    std::printf("    %-18s p50 %8lld  p99 %8lld  p99.9 %8lld  max %8lld us\n", name,
+                static_cast<long long>(h.percentile(50.0)), static_cast<long long>(h.percentile(99.0)),
+                static_cast<long long>(h.percentile(99.9)), static_cast<long long>(h.max()));
+}
+
+//--> Publish at one rate in one format for the configured time
+static void runOnce(const BenchOptions& options, double rate, PayloadFormat format, BME280* sensor,
+                    InflightPublisher& publisher, Receiver& receiver) {
+    Stages stages;
+    for (auto& stamp : publishedUs) stamp.store(0);
+    receiver.start(&stages);
+
+    JsonWriter<256> json;
+    PeriodicTimer timer(std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate)));
+    uint64_t total = static_cast<uint64_t>(rate * options.seconds);
+    for (uint64_t seq = 1; seq <= total; seq++) {
+        //--> Acquisition, the stamp every later stage is measured from
+        float temp = 21.5f, hum = 45.0f, pres = 1013.25f;
+        int64_t acquiredUs;
+        if (sensor) {
+            BME280Reading sample = sensor->readAll();
+            acquiredUs = wallMicros(sample.timestamp);
+            temp = sample.temperature;
+            hum = sample.humidity;
+            pres = sample.pressure;
+        } else {
+            acquiredUs = wallMicros(monotonicNs());
+        }
+
+        //--> Same formatting as main.cpp, one format per run
+        std::string payload;
+        if (format == PayloadFormat::Binary) {
+            uint8_t record[TELEMETRY_HEADER_SIZE + 3 * 4];
+            const float values[3] = { temp, hum, pres };
+            size_t size = encodeTelemetry(record, sizeof(record), TelemetryType::Sensor, static_cast<uint32_t>(seq), acquiredUs, values, 3);
+            payload.assign(reinterpret_cast<const char*>(record), size);
+        } else {
+            payload = json.record<SENSOR_FIELDS>(seq, acquiredUs, temp, hum, pres);
+        }
+        auto msg = mqtt::make_message(TOPIC, std::move(payload));
+        msg->set_qos(options.qos);
+
+        //--> Stamp before handing off, the subscriber may see the message before publish() returns
+        int64_t publishUs = wallMicros(monotonicNs());
+        publishedUs[seq % PUBLISH_RING].store(publishUs, std::memory_order_release);
+        publisher.publish(msg);
+        stages.acquireToPublish.record(publishUs - acquiredUs);
+        stages.sent++;
+
+        timer.wait();
+    }
+
+    //--> Give the last messages time to arrive, then stop counting
+    std::this_thread::sleep_for(DRAIN_TIME);
+    receiver.stop();
+
+    std::printf("%s, %.0f Hz, QoS%d: sent %llu, received %llu, lost %lld, unreadable %llu\n",
+                format == PayloadFormat::Binary ? "binary" : "json", rate, options.qos,
+                static_cast<unsigned long long>(stages.sent), static_cast<unsigned long long>(stages.received.load()),
+                static_cast<long long>(stages.sent - stages.received.load()), static_cast<unsigned long long>(stages.unreadable.load()));
+    printStage("acquire->publish", stages.acquireToPublish);
+    printStage("publish->receive", stages.publishToReceive);
+    printStage("acquire->receive", stages.acquireToReceive);
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options = parseOptions(argc, argv);
+
+    //--> Real sensor only on request, the bench also runs on a pc
+    std::unique_ptr<BME280> sensor;
+    if (options.sensor) {
+        sensor = std::make_unique<BME280>();
+        if (!sensor->begin(0x76, 1)) {
+            std::cerr << "sensor not detected" << std::endl;
+            return 1;
+        }
+    }
+
+    //--> Two clients, the subscriber is connected first so no message is missed
+    mqtt::async_client subscriber(options.broker, "bench-latency-sub");
+    mqtt::async_client client(options.broker, "bench-latency-pub");
+    Receiver receiver;
+    subscriber.set_callback(receiver);
+    mqtt::connect_options connOpts;
+    try {
+        subscriber.connect(connOpts)->wait();
+        subscriber.subscribe(TOPIC, options.qos)->wait();
+        client.connect(connOpts)->wait();
+    } catch (const mqtt::exception& exc) {
+        std::cerr << "cannot reach " << options.broker << ": " << exc.what() << std::endl;
+        return 1;
+    }
+
+    InflightPublisher publisher(client, MAX_IN_FLIGHT, BackpressurePolicy::DropNewest);
+    for (PayloadFormat format : options.formats) {
+        for (double rate : options.rates) {
+            if (rate > 0.0) runOnce(options, rate, format, sensor.get(), publisher, receiver);
+        }
+    }
+
+    PublisherMetrics m = publisher.metrics();
+    std::printf("publisher: %llu published, %llu dropped (window of %zu full)\n",
+                static_cast<unsigned long long>(m.published), static_cast<unsigned long long>(m.dropped), MAX_IN_FLIGHT);
+
+    client.disconnect()->wait();
+    subscriber.disconnect()->wait();
+    return 0;
+}
@@ -15,6 +15,7 @@
  */
 
 #include "bme280.hpp"
+#include "clock.hpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -98,7 +99,11 @@ void BME280::readCalibration() {
 float BME280::readTemperature() {
     //--> Read raw 20-bit ADC temperature data (stored in 3 registers)
     int32_t adc_T = (read8(0xFA) << 12) | (read8(0xFB) << 4) | (read8(0xFC) >> 4);
+    return compensateTemperature(adc_T);
+}
 
+//--> Temperature compensation, also updates t_fine
+float BME280::compensateTemperature(int32_t adc_T) {
     //--> First temperature compensation step
     float var1 = ((adc_T / 16384.0f) - (dig_T1 / 1024.0f)) * dig_T2;
 
@@ -126,7 +131,11 @@ float BME280::readPressure() {
 
     //--> Raw 20-bit ADC pressure data
     int32_t adc_P = (read8(0xF7) << 12) | (read8(0xF8) << 4) | (read8(0xF9) >> 4);
+    return compensatePressure(adc_P);
+}
 
+//--> Pressure compensation, needs t_fine of the same measurement
+float BME280::compensatePressure(int32_t adc_P) {
     //--> Long black magic math from datasheet...
     int64_t var1, var2, p;
 
@@ -160,7 +169,11 @@ float BME280::readHumidity() {
 
     //--> Raw 16-bit ADC humidity data
     int32_t adc_H = (read8(0xFD) << 8) | read8(0xFE);
+    return compensateHumidity(adc_H);
+}
 
+//--> Humidity compensation, needs t_fine of the same measurement
+float BME280::compensateHumidity(int32_t adc_H) {
     //--> Long black magic math from datasheet...
     int32_t v_x1_u32r = t_fine - 76800;
     v_x1_u32r = (((((adc_H << 14) - (dig_H4 << 20) - (dig_H5 * v_x1_u32r)) + 16384) >> 15) *
@@ -181,3 +194,25 @@ float BME280::readHumidity() {
     lastHumidity = humidity;
     return humidity;
 }
+
+//--> Read all channels in one burst, so they belong to the same measurement
+BME280Reading BME280::readAll() {
+    //--> press (3), temp (3), hum (2) registers
+    uint8_t raw[8];
+    dev->readBlock(BME280_REG_PRESS_MSB, raw, sizeof(raw));
+
+    //--> Stamped when the transaction completed, not when the value is published
+    BME280Reading reading;
+    reading.timestamp = monotonicNs();
+    reading.sequence = ++readSequence;
+
+    int32_t adc_P = (raw[0] << 12) | (raw[1] << 4) | (raw[2] >> 4);
+    int32_t adc_T = (raw[3] << 12) | (raw[4] << 4) | (raw[5] >> 4);
+    int32_t adc_H = (raw[6] << 8) | raw[7];
+
+    //--> Temperature first, it sets t_fine for the other two
+    reading.temperature = compensateTemperature(adc_T);
+    reading.pressure = compensatePressure(adc_P);
+    reading.humidity = compensateHumidity(adc_H);
+    return reading;
+}
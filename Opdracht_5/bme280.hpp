@@ -17,6 +17,15 @@
 #include <thread>
 #include <chrono>
 
+//--> One burst read of all channels, range checked like the read functions
+struct BME280Reading {
+    float temperature;      // °C
+    float pressure;         // hPa
+    float humidity;         // %
+    uint64_t sequence;      // counts every read of this sensor, a gap means lost samples
+    int64_t timestamp;      // CLOCK_MONOTONIC ns when the i2c read completed
+};
+
 //--> BME280 sensor class
 class BME280 {
 
@@ -33,6 +42,9 @@ public:
     float readPressure();
     float readHumidity();
 
+    //--> All channels from one i2c transaction, stamped with its completion time
+    BME280Reading readAll();
+
 //-> Private functions and variables
 private:
     //--> Pointer to i2c device and address
@@ -51,6 +63,9 @@ private:
     //--> variable from bosch datasheet
     int32_t t_fine;         
 
+    //--> Number of readAll calls that reached the sensor
+    uint64_t readSequence = 0;
+
     //--> Store last known valid readings
     float lastTemperature = 20.0;
     float lastHumidity = 50.0;
@@ -66,6 +81,11 @@ private:
 
     //--> Read calibration data from sensor
     void readCalibration();
+
+    //--> Datasheet compensation of raw ADC values, range checked
+    float compensateTemperature(int32_t adc_T);
+    float compensatePressure(int32_t adc_P);
+    float compensateHumidity(int32_t adc_H);
 };
 
 #endif //--> BME280_HPP
@@ -65,3 +65,9 @@ void I2CDevice::write8(uint8_t reg, uint8_t value) {
     uint8_t buf[2] = { reg, value };
     if (write(file, buf, 2) != 2) throw std::runtime_error("I2C write failed (write8)");
 }
+
+//--> burst read len bytes, register pointer auto increments on the sensor
+void I2CDevice::readBlock(uint8_t reg, uint8_t* buf, size_t len) {
+    if (write(file, &reg, 1) != 1) throw std::runtime_error("I2C write failed (readBlock)");
+    if (read(file, buf, len) != static_cast<ssize_t>(len)) throw std::runtime_error("I2C read failed (readBlock)");
+}
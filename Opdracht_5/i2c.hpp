@@ -10,6 +10,7 @@
 #define I2C_HPP
 
 #include <cstdint>
+#include <cstddef>
 #include <string>
 
 //--> i2c class
@@ -31,6 +32,9 @@ public:
     int16_t  readS16_LE(uint8_t reg);
     void     write8(uint8_t reg, uint8_t value);
 
+    //--> Burst read of len bytes starting at reg (one i2c transaction)
+    void     readBlock(uint8_t reg, uint8_t* buf, size_t len);
+
 //--> Global variables
 private:
     int file;
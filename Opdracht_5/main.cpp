@@ -11,46 +11,299 @@
  */
 
 #include "bme280.hpp"
+#include "realtime.hpp"
+#include "clock.hpp"
+#include "inflight_publisher.hpp"
+#include "batch_publisher.hpp"
+#include "json_writer.hpp"
+#include "telemetry_codec.hpp"
+#include "connection_manager.hpp"
+#include "report_filter.hpp"
+#include "topic_aliases.hpp"
+#include "alarm_engine.hpp"
+#include "timeseries_store.hpp"
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
 #include <thread>
 #include <chrono>
-#include <sstream>
+#include <vector>
 #include <mqtt/async_client.h>
 
 //--> mqtt setup
 const std::string SERVER_ADDRESS{"tcp://192.168.50.95:1883"};
 const std::string CLIENT_ID{"WIETSE-PI"};
 const std::string TOPIC{"school"};
-const int QOS = 1;
+const std::string BINARY_TOPIC{TOPIC + TELEMETRY_BINARY_SUFFIX};
+const std::string METRICS_TOPIC{"school/metrics"};
+const std::string ALARM_TOPIC{TOPIC + "/alarm/"};               // + rule name
+const int TELEMETRY_QOS = 0;                                    // samples, the spool still keeps them during an outage
+const int ALARM_QOS = 1;                                        // alarm raised / cleared, must arrive
+
+//--> publish window, at most this many QoS1 messages wait for an ACK
+const size_t MAX_IN_FLIGHT = 16;
+const BackpressurePolicy BACKPRESSURE = BackpressurePolicy::DropNewest;
+const int METRICS_EVERY = 12;                           // samples between metrics messages
+
+//--> payload fields, key and decimals
+inline constexpr JsonField SENSOR_FIELDS[] = {
+    {"seq", 0}, {"ts_us", 0}, {"temperature", 2}, {"humidity", 2}, {"pressure", 2}
+};
+inline constexpr JsonField ALARM_FIELDS[] = {
+    {"active", 0}, {"value", 2}, {"limit", 2}, {"ts_us", 0}
+};
+inline constexpr JsonField METRICS_FIELDS[] = {
+    {"in_flight", 0}, {"max_in_flight", 0}, {"published", 0}, {"delivered", 0}, {"failed", 0}, {"dropped", 0},
+    {"latency_last_us", 0}, {"latency_avg_us", 0}, {"latency_max_us", 0},
+    {"spool_queued", 0}, {"spool_segments", 0}, {"spool_spooled", 0}, {"spool_replayed", 0}, {"spool_dropped", 0},
+    {"connected", 0}, {"connects", 0}, {"reconnects", 0}, {"connect_failures", 0}, {"connection_lost", 0},
+    {"samples_offered", 0}, {"samples_reported", 0}, {"heartbeats", 0},
+    {"alarms_active", 0}, {"alarms_raised", 0}, {"alarms_cleared", 0},
+    {"store_samples", 0}, {"store_dropped", 0}, {"store_bytes", 0}, {"store_raw_bytes", 0}
+};
+
+//--> report-by-exception, deadband per channel (temperature, humidity, pressure) around sensor noise, select with --report
+const std::vector<ChannelDeadband> SENSOR_DEADBANDS = {
+    {0.1f, 0.0f},       // °C
+    {0.5f, 0.0f},       // %
+    {0.1f, 0.0f}        // hPa
+};
+const auto REPORT_HEARTBEAT = std::chrono::seconds(60);     // max silence on a stable site
+
+//--> alarm rules on every raw sample (before the report filter), rates per minute, replace with --rules <file>, format in common/alarm_engine.hpp
+inline constexpr std::string_view SENSOR_NAMES[] = { "temperature", "humidity", "pressure" };
+const char* const DEFAULT_ALARM_RULES = R"(
+temp_high       temperature  above 30    clear 29    for 60
+temp_low        temperature  below 10    clear 11    for 60
+humidity_high   humidity     above 80    clear 75    for 60
+temp_rising     temperature  rising 2    clear 1     for 120
+pressure_falling pressure    falling 0.1 clear 0.05  for 600
+)";
+
+//--> store-and-forward spool for broker outages, 64 x 1 MiB on disk, replayed at 20 msg/s
+SpoolOptions spoolOptions() {
+    SpoolOptions options;
+    options.directory = "spool";
+    options.segmentSize = 1024 * 1024;
+    options.maxSegments = 64;
+    options.dropPolicy = SpoolDropPolicy::DropOldest;
+    options.drainRate = 20.0;
+    options.drainBurst = 20;
+    return options;
+}
+
+//--> local time-series store of every raw sample, one segment file per day in ./store (or --store <dir>), written every 5 minutes
+const std::string STORE_SERIES{"bme280"};
+const std::vector<std::string> STORE_FIELDS = { "temperature", "humidity", "pressure" };
+const std::vector<int32_t> STORE_SCALES = { 100, 100, 100 };    // 0.01 °C, 0.01 %, 0.01 hPa, the resolution of the sensor
+TimeSeriesOptions storeOptions(const char* directory) {
+    TimeSeriesOptions options;
+    options.directory = directory;
+    options.partition = std::chrono::hours(24);
+    options.flushInterval = std::chrono::seconds(300);
+    return options;
+}
+
+//--> batching of the sensor topic, trades a bit of latency for far fewer messages at high sample rates
+const BatchLimits SENSOR_BATCH{20, std::chrono::milliseconds(500)};
+const BatchLimits SENSOR_BINARY_BATCH{20, std::chrono::milliseconds(500), BatchFraming::Concatenate};
+
+//--> MQTT v5 mode (--mqtt5): topic aliases, metadata as user properties on the first message per topic
+const uint32_t SESSION_EXPIRY = 3600;                   // s the broker keeps the session after a disconnect
+const TopicMetadata SENSOR_UNITS = {
+    {"unit.temperature", "°C"}, {"unit.humidity", "%"}, {"unit.pressure", "hPa"}
+};
+
+//--> Metadata per topic, units plus the payload schema
+std::vector<std::pair<std::string, TopicMetadata>> topicMetadata() {
+    TopicMetadata json = SENSOR_UNITS, binary = SENSOR_UNITS;
+    json.emplace_back("schema", "sensor-json/1");
+    binary.emplace_back("schema", "telemetry-bin/1");
+    return { {TOPIC, json}, {BINARY_TOPIC, binary}, {METRICS_TOPIC, {{"schema", "metrics-json/1"}}} };
+}
 
 //--> mqtt authentication
 const std::string MQTT_USERNAME{"school"};
 const std::string MQTT_PASSWORD{"Han@2025!"};
 
-//--> Function to publish sensor data
-void publishData(mqtt::async_client& client, float temp, float hum, float pres) {
-    //--> Build formatted payload
-    std::ostringstream payload;
-    payload << "{"
-            << "\"temperature\":" << temp << ","
-            << "\"humidity\":" << hum << ","
-            << "\"pressure\":" << pres
-            << "}";
-
-    //--> Create mqtt message
-    auto msg = mqtt::make_message(TOPIC, payload.str());
-    msg->set_qos(QOS);
-
-    //--> Publish and handle errors
-    try {
-        client.publish(msg)->wait_for(std::chrono::seconds(10));
-    } catch (const mqtt::exception& exc) {
-        std::cerr << "error publishing" << exc.what() << std::endl;
+//--> sample loop setup, period can be changed with --period-ms
+const auto SAMPLE_PERIOD = std::chrono::seconds(5);
+const int JITTER_REPORT_EVERY = 60;                     // samples between jitter reports
+
+//--> Read command line options, --realtime [--cpu N] [--priority N]
+RealtimeOptions parseRealtimeOptions(int argc, char* argv[]) {
+    RealtimeOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--realtime") == 0) options.enabled = true;
+        else if (std::strcmp(argv[i], "--cpu") == 0 && i + 1 < argc) options.cpu = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--priority") == 0 && i + 1 < argc) options.priority = std::atoi(argv[++i]);
+    }
+    return options;
+}
+
+//--> Read the sample period from --period-ms N, zero or less when N is not a positive number
+std::chrono::nanoseconds parsePeriod(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--period-ms") == 0) return std::chrono::milliseconds(std::atoi(argv[i + 1]));
+    }
+    return SAMPLE_PERIOD;
+}
+
+//--> Read the payload format from --format json|binary|both
+PayloadFormat parseFormat(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--format") == 0) return parsePayloadFormat(argv[i + 1]);
     }
+    return PayloadFormat::Json;
+}
+
+//--> True when --mqtt5 is given
+bool parseMqtt5(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--mqtt5") == 0) return true;
+    }
+    return false;
+}
+
+//--> Read the filter mode from --report all|deadband|swinging-door
+ReportMode parseReport(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--report") == 0) return parseReportMode(argv[i + 1]);
+    }
+    return ReportMode::All;
+}
+
+//--> Read the alarm rule file from --rules <file>, nullptr for the default rules
+const char* parseRules(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--rules") == 0) return argv[i + 1];
+    }
+    return nullptr;
+}
+
+//--> Read the store directory from --store <dir>
+const char* parseStore(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--store") == 0) return argv[i + 1];
+    }
+    return "store";
+}
+
+//--> Print wake-up latency percentiles of the sample loop
+void printJitter(JitterReport& jitter) {
+    JitterReport::Summary s = jitter.summary();
+    std::cout << "Wake-up latency over " << s.count << " samples: "
+              << "p50 " << s.p50 / 1000 << " us, "
+              << "p99 " << s.p99 / 1000 << " us, "
+              << "max " << s.max / 1000 << " us" << std::endl;
+}
+
+//--> Payloads are formatted into this buffer, no allocation per message
+JsonWriter<256> json;
+JsonWriter<JsonLayout<METRICS_FIELDS>::maxIntegerSize()> metricsJson;     // sized from its fields, grows with the record
+
+//--> Publish one sample in the selected formats
+void publishRecord(BatchPublisher& publisher, PayloadFormat format, uint64_t seq, int64_t timestampUs, float temp, float hum, float pres) {
+    //--> Build formatted payload, seq and ts_us (acquisition time) let consumers see gaps and latency
+    if (format != PayloadFormat::Binary) {
+        std::string_view payload = json.record<SENSOR_FIELDS>(seq, timestampUs, temp, hum, pres);
+
+        //--> Batched per topic, the in-flight publisher underneath never waits for the ACK
+        publisher.add(TOPIC, payload);
+    }
+
+    //--> Same sample as a packed binary record on its own topic
+    if (format != PayloadFormat::Json) {
+        uint8_t record[TELEMETRY_HEADER_SIZE + 3 * 4];
+        const float values[3] = { temp, hum, pres };
+        size_t size = encodeTelemetry(record, sizeof(record), TelemetryType::Sensor, static_cast<uint32_t>(seq), timestampUs, values, 3);
+        publisher.add(BINARY_TOPIC, std::string_view(reinterpret_cast<const char*>(record), size));
+    }
+}
+
+//--> Function to publish sensor data, the filter drops samples that carry no new information
+void publishData(BatchPublisher& publisher, ReportFilter& filter, PayloadFormat format, uint64_t seq, int64_t timestampUs, float temp, float hum, float pres) {
+    const float values[3] = { temp, hum, pres };
+    ReportPoint points[2];
+    size_t count = filter.offer(seq, timestampUs, values, points);
+
+    for (size_t i = 0; i < count; i++) {
+        const ReportPoint& p = points[i];
+        publishRecord(publisher, format, p.sequence, p.timestampUs, p.values[0], p.values[1], p.values[2]);
+    }
+}
+
+//--> Check the alarm rules on the raw sample, raises and clears skip the batcher and the spool backlog and go out at once with QoS1
+void checkAlarms(InflightPublisher& publisher, AlarmEngine& alarms, std::vector<AlarmEvent>& events, int64_t timestampUs, float temp, float hum, float pres) {
+    const float values[3] = { temp, hum, pres };
+    size_t count = alarms.evaluate(timestampUs, values, events.data());
+
+    for (size_t i = 0; i < count; i++) {
+        const AlarmEvent& e = events[i];
+        const std::string& name = alarms.name(e.rule);
+        std::cout << "Alarm: " << name << (e.active ? " raised" : " cleared") << ", value " << e.value << " limit " << e.limit << std::endl;
+
+        auto msg = mqtt::make_message(ALARM_TOPIC + name, std::string(json.record<ALARM_FIELDS>(e.active ? 1 : 0, e.value, e.limit, e.timestampUs)));
+        msg->set_qos(ALARM_QOS);
+        publisher.publishUrgent(msg);
+    }
+}
+
+//--> Publish and print publish latency, in-flight depth, spool and connection state
+void publishMetrics(ConnectionManager& connection, InflightPublisher& publisher, Spool& spool, const ReportFilter& filter, const AlarmEngine& alarms, TimeSeriesStore& store) {
+    PublisherMetrics m = publisher.metrics();
+    SpoolMetrics s = spool.metrics();
+    ConnectionMetrics c = connection.metrics();
+    ReportMetrics r = filter.metrics();
+    AlarmMetrics a = alarms.metrics();
+    TimeSeriesMetrics t = store.metrics();
+
+    std::string payload(metricsJson.record<METRICS_FIELDS>(m.inFlight, m.maxInFlight, m.published, m.delivered, m.failed,
+                                                    m.dropped, m.lastLatencyUs, m.avgLatencyUs, m.maxLatencyUs,
+                                                    s.queued, s.segments, s.spooled, s.replayed, s.dropped,
+                                                    c.state == ConnectionState::Connected ? 1 : 0, c.connects,
+                                                    c.reconnects, c.failedAttempts, c.lost,
+                                                    r.offered, r.reported, r.heartbeats,
+                                                    a.active, a.raised, a.cleared,
+                                                    t.samples, t.dropped, t.bytes, t.rawBytes));
+    if (payload.empty()) {
+        std::cerr << "metrics record does not fit its buffer, not published" << std::endl;
+        return;
+    }
+    std::cout << "Publisher: " << payload << " (mqtt " << connectionStateName(c.state) << ")" << std::endl;
+
+    //--> Metrics are only interesting live, they skip the spool and its backlog
+    if (c.state != ConnectionState::Connected) return;
+    auto msg = mqtt::make_message(METRICS_TOPIC, payload);
+    msg->set_qos(0);
+    publisher.publishLive(msg);
 }
 
 //--> Setup
-int main() {
+int main(int argc, char* argv[]) {
+    //--> Optional real-time mode for the sample loop
+    RealtimeOptions rtOptions = parseRealtimeOptions(argc, argv);
+    std::chrono::nanoseconds period = parsePeriod(argc, argv);
+    if (period.count() <= 0) {
+        std::cerr << "--period-ms must be at least 1" << std::endl;
+        return 1;
+    }
+    PayloadFormat format = parseFormat(argc, argv);
+    ReportFilter filter(SENSOR_DEADBANDS, parseReport(argc, argv), REPORT_HEARTBEAT);
+    bool mqtt5 = parseMqtt5(argc, argv);
+    const char* rulesPath = parseRules(argc, argv);
+    const char* storePath = parseStore(argc, argv);
+
+    //--> Alarm rules are compiled once, a bad rule stops the program here
+    std::unique_ptr<AlarmEngine> alarms;
+    try {
+        alarms = std::make_unique<AlarmEngine>(rulesPath ? readAlarmRules(rulesPath) : DEFAULT_ALARM_RULES, SENSOR_NAMES, std::size(SENSOR_NAMES));
+    } catch (const std::runtime_error& exc) {
+        std::cerr << "alarm rules failed: " << exc.what() << std::endl;
+        return 1;
+    }
+    std::vector<AlarmEvent> alarmEvents(alarms->size());
+
     //--> Create sensor object
     BME280 sensor;
 
@@ -61,43 +314,115 @@ int main() {
     }
 
     //--> Create mqtt client
-    mqtt::async_client client(SERVER_ADDRESS, CLIENT_ID);
+    mqtt::async_client client(SERVER_ADDRESS, CLIENT_ID, mqtt::create_options(mqtt5 ? MQTTVERSION_5 : MQTTVERSION_DEFAULT));
 
-    //--> Setup mqtt authentication
+    //--> Setup mqtt authentication, the connection manager turns on session resumption
     mqtt::connect_options connOpts;
-    connOpts.set_clean_session(true);
     connOpts.set_user_name(MQTT_USERNAME);
     connOpts.set_password(MQTT_PASSWORD);
+    if (mqtt5) {
+        connOpts.set_mqtt_version(MQTTVERSION_5);
+        connOpts.set_properties({ mqtt::property(mqtt::property::SESSION_EXPIRY_INTERVAL, SESSION_EXPIRY) });
+    }
+
+    //--> Topic aliases, valid for one connection, the broker tells how many we may use
+    TopicAliases aliases;
+    for (auto& topic : topicMetadata()) aliases.addTopic(topic.first, topic.second);
+
+    //--> Spool for samples that cannot be published right now
+    std::unique_ptr<Spool> spool;
+    try {
+        spool = std::make_unique<Spool>(spoolOptions());
+    } catch (const std::runtime_error& exc) {
+        std::cerr << "spool failed: " << exc.what() << std::endl;
+        return 1;
+    }
 
-    //--> Connect to mqtt broker
+    //--> Local store of every sample, its writer thread is started before real-time mode like the connection thread
+    std::unique_ptr<TimeSeriesStore> store;
+    uint16_t storeSeries;
     try {
-        client.connect(connOpts)->wait();
-        std::cout << "mqtt ok" << std::endl;
-    } catch (const mqtt::exception& exc) {
-        std::cerr << "mqtt failed" << exc.what() << std::endl;
+        store = std::make_unique<TimeSeriesStore>(storeOptions(storePath));
+        storeSeries = store->addSeries(STORE_SERIES, STORE_FIELDS, STORE_SCALES);
+    } catch (const std::runtime_error& exc) {
+        std::cerr << "store failed: " << exc.what() << std::endl;
         return 1;
     }
 
+    //--> Connect and keep reconnecting from a separate thread, without a broker the samples go to the spool.
+    //--> Started before real-time mode so the thread keeps normal priority and does not share the sample cpu
+    ConnectionManager connection(client, connOpts);
+    if (mqtt5) {
+        connection.setConnectHandler([&aliases](const mqtt::connect_response& response) {
+            const mqtt::properties& props = response.get_properties();
+            aliases.reset(props.contains(mqtt::property::TOPIC_ALIAS_MAXIMUM)
+                          ? mqtt::get<uint16_t>(props.get(mqtt::property::TOPIC_ALIAS_MAXIMUM)) : 0);
+        });
+        connection.setConnectionLostHandler([&aliases] { aliases.reset(0); });
+    }
+    connection.start();
+
+    //--> Switch to real-time only after setup, connecting is allowed to be slow
+    if (rtOptions.enabled) {
+        std::string error;
+        if (enableRealtime(rtOptions, error)) std::cout << "realtime mode on" << std::endl;
+        else std::cerr << "realtime mode failed (" << error << "), running normal" << std::endl;
+    }
+
+    //--> Publisher that never waits for the broker
+    InflightPublisher publisher(client, MAX_IN_FLIGHT, BACKPRESSURE);
+    publisher.setSpool(spool.get());
+    if (mqtt5) publisher.setTopicAliases(&aliases);
+    BatchPublisher batcher(publisher, TELEMETRY_QOS);
+    batcher.setLimits(TOPIC, SENSOR_BATCH);
+    batcher.setLimits(BINARY_TOPIC, SENSOR_BINARY_BATCH);
+
+    //--> Measure how late every wake-up is
+    JitterReport jitter;
+    PeriodicTimer timer(period);
+    int samples = 0;
+
     //--> Loop
     while(1) {
-        //--> Read sensor values
-        float temperature = sensor.readTemperature();
-        float pressure = sensor.readPressure();
-        float humidity = sensor.readHumidity();
+        //--> Replay what was spooled during an outage, limited to the drain rate
+        publisher.drainSpool();
+
+        //--> Read sensor values, all from one burst read
+        BME280Reading sample = sensor.readAll();
+        float temperature = sample.temperature;
+        float pressure = sample.pressure;
+        float humidity = sample.humidity;
+
+        //--> Acquisition time of the i2c read as unix time
+        int64_t timestampUs = wallMicros(sample.timestamp);
 
         //--> Print current environment information
+        std::cout << "Sample: " << sample.sequence << " @ " << timestampUs << " us" << std::endl;
         std::cout << "Temperature: " << temperature << " °C" << std::endl;
         std::cout << "Pressure: " << pressure << " hPa" << std::endl;
         std::cout << "Humidity: " << humidity << " %" << std::endl;
 
+        //--> Every raw sample into the local store, compressed in memory, written to disk every few minutes
+        const float values[3] = { temperature, humidity, pressure };
+        store->append(storeSeries, timestampUs, values);
+
+        //--> Alarms first, on every sample so the report filter cannot hide a crossing
+        checkAlarms(publisher, *alarms, alarmEvents, timestampUs, temperature, humidity, pressure);
+
         //--> Publish sensor data to mqtt
-        publishData(client, temperature, humidity, pressure);
+        publishData(batcher, filter, format, sample.sequence, timestampUs, temperature, humidity, pressure);
+        batcher.poll();
+
+        //--> Report jitter and publisher metrics every so often
+        samples++;
+        if (samples % JITTER_REPORT_EVERY == 0) printJitter(jitter);
+        if (samples % METRICS_EVERY == 0) publishMetrics(connection, publisher, *spool, filter, *alarms, *store);
 
-        //--> Sleep
-        std::this_thread::sleep_for(std::chrono::seconds(5));
+        //--> Sleep until the next fixed deadline
+        jitter.record(timer.wait());
     }
 
-    //--> Disconnect mqtt
-    client.disconnect()->wait();
+    //--> Stop reconnecting and disconnect mqtt
+    connection.stop();
     return 0;
 }
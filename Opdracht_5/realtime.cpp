@@ -0,0 +1,116 @@
+/*!
+ * \file      realtime.cpp
+ * \brief     Opt-in real-time mode and jitter measurement for the sample loop
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "realtime.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+//--> Apply scheduling, pinning and memory locking to the calling thread
+bool enableRealtime(const RealtimeOptions& options, std::string& error) {
+    //--> Lock current and future pages so nothing gets swapped out during the loop
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        error = std::string("mlockall: ") + std::strerror(errno);
+        return false;
+    }
+
+    //--> Pin to one cpu
+    if (options.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(options.cpu, &set);
+        int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        if (rc != 0) {
+            error = std::string("cpu affinity: ") + std::strerror(rc);
+            return false;
+        }
+    }
+
+    //--> Fixed priority real-time scheduling
+    sched_param param{};
+    param.sched_priority = options.priority;
+    int rc = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (rc != 0) {
+        error = std::string("SCHED_FIFO: ") + std::strerror(rc);
+        return false;
+    }
+
+    //--> With MCL_FUTURE the touched stack pages stay resident
+    prefaultStack(options.stackPrefault);
+    return true;
+}
+
+//--> Touch the stack, noinline so the compiler keeps the array on this frame
+__attribute__((noinline)) void prefaultStack(size_t bytes) {
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(__builtin_alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) stack[i] = 0;
+}
+
+//--> Touch every page of a buffer
+void prefaultBuffer(void* buffer, size_t bytes) {
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(buffer);
+    for (size_t i = 0; i < bytes; i += 4096) p[i] = p[i];
+}
+
+//--> Constructor
+PeriodicTimer::PeriodicTimer(std::chrono::nanoseconds period) : periodNs(period.count()) {
+    clock_gettime(CLOCK_MONOTONIC, &next);
+}
+
+//--> Sleep to the next absolute deadline and measure how late we woke up
+int64_t PeriodicTimer::wait() {
+    next.tv_nsec += periodNs % 1000000000;
+    next.tv_sec += periodNs / 1000000000;
+    if (next.tv_nsec >= 1000000000) {
+        next.tv_nsec -= 1000000000;
+        next.tv_sec++;
+    }
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) == EINTR) { }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - next.tv_sec) * 1000000000LL + (now.tv_nsec - next.tv_nsec);
+}
+
+//--> Constructor
+JitterReport::JitterReport(size_t window) : samples(window), sorted(window) {
+    prefaultBuffer(samples.data(), samples.size() * sizeof(int64_t));
+    prefaultBuffer(sorted.data(), sorted.size() * sizeof(int64_t));
+}
+
+//--> Store in a ring, no allocation
+void JitterReport::record(int64_t latencyNs) {
+    samples[next] = latencyNs;
+    next = (next + 1) % samples.size();
+    if (count < samples.size()) count++;
+}
+
+//--> Percentiles by sorting a copy of the window
+JitterReport::Summary JitterReport::summary() {
+    Summary s{count, 0, 0, 0};
+    if (count == 0) return s;
+
+    std::copy(samples.begin(), samples.begin() + count, sorted.begin());
+    auto end = sorted.begin() + count;
+    std::sort(sorted.begin(), end);
+
+    s.p50 = sorted[(count - 1) * 50 / 100];
+    s.p99 = sorted[(count - 1) * 99 / 100];
+    s.max = sorted[count - 1];
+    return s;
+}
+
+//--> Clear the window
+void JitterReport::reset() {
+    next = 0;
+    count = 0;
+}
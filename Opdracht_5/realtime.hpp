@@ -0,0 +1,90 @@
+/*!
+ * \file      realtime.hpp
+ * \brief     Opt-in real-time mode and jitter measurement for the sample loop
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Puts the calling thread on SCHED_FIFO, pins it to one CPU, locks all memory
+ * and pre-faults the stack so the sample loop does not get page faults or
+ * scheduler delays. PeriodicTimer sleeps to absolute CLOCK_MONOTONIC deadlines
+ * and JitterReport keeps the wake-up latencies for a p50/p99/max report.
+ *
+ */
+
+#ifndef REALTIME_HPP
+#define REALTIME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <time.h>
+
+//--> Real-time settings, everything is off unless enabled is set
+struct RealtimeOptions {
+    bool enabled = false;
+    int priority = 80;                  // SCHED_FIFO priority 1..99
+    int cpu = -1;                       // cpu to pin to, -1 = no pinning
+    size_t stackPrefault = 256 * 1024;  // bytes of stack to touch before the loop starts
+};
+
+//--> Apply the options to the calling thread, error tells which step failed
+bool enableRealtime(const RealtimeOptions& options, std::string& error);
+
+//--> Touch memory up front so the loop never page faults on it
+void prefaultStack(size_t bytes);
+void prefaultBuffer(void* buffer, size_t bytes);
+
+//--> Sleeps until fixed, absolute deadlines so the period does not drift
+class PeriodicTimer {
+
+//-> Public functions
+public:
+    //--> Constructor, first deadline is one period from now
+    explicit PeriodicTimer(std::chrono::nanoseconds period);
+
+    //--> Sleep until the next deadline, returns how late the wake-up was in ns
+    int64_t wait();
+
+//-> Private variables
+private:
+    struct timespec next;
+    int64_t periodNs;
+};
+
+//--> Wake-up latency statistics over a fixed window of samples
+class JitterReport {
+
+//-> Public functions
+public:
+    //--> Summary of the recorded window
+    struct Summary {
+        size_t count;
+        int64_t p50;
+        int64_t p99;
+        int64_t max;
+    };
+
+    //--> Constructor, all storage is allocated and touched here
+    explicit JitterReport(size_t window = 4096);
+
+    //--> Record one latency in ns, oldest value is overwritten when the window is full
+    void record(int64_t latencyNs);
+
+    //--> Percentiles of the current window
+    Summary summary();
+
+    //--> Forget all recorded values
+    void reset();
+
+//-> Private variables
+private:
+    std::vector<int64_t> samples;
+    std::vector<int64_t> sorted;
+    size_t next = 0;
+    size_t count = 0;
+};
+
+#endif //--> REALTIME_HPP
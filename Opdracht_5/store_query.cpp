@@ -0,0 +1,77 @@
+/*!
+ * \file      store_query.cpp
+ * \brief     Query the local time-series store of bme280_mqtt on the Pi
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Prints min, max and mean per field of the last --last seconds (default one
+ * hour), or with --raw every sample of that window as csv. --from and --to
+ * (unix seconds) give another window. Reads the segment files directly, so
+ * it can run while bme280_mqtt is writing them; the samples of the last few
+ * minutes are still in memory there and show up after the next write.
+ *
+ * command used to compile:  g++ -O2 store_query.cpp ../common/timeseries_index.cpp ../common/timeseries_reader.cpp -I../common -o store_query
+ * then to run: ./store_query [--store store] [--series bme280] [--last 3600] [--from <s> --to <s>] [--raw]
+ */
+
+#include "clock.hpp"
+#include "timeseries_reader.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    std::string directory = "store";
+    std::string series = "bme280";
+    int64_t lastS = 3600, fromS = 0, toS = 0;
+    bool raw = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--raw") == 0) raw = true;
+        else if (i + 1 >= argc) break;
+        else if (std::strcmp(argv[i], "--store") == 0) directory = argv[++i];
+        else if (std::strcmp(argv[i], "--series") == 0) series = argv[++i];
+        else if (std::strcmp(argv[i], "--last") == 0) lastS = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--from") == 0) fromS = std::atoll(argv[++i]);
+        else if (std::strcmp(argv[i], "--to") == 0) toS = std::atoll(argv[++i]);
+    }
+
+    int64_t nowUs = wallMicros(monotonicNs());
+    int64_t toUs = toS ? toS * 1000000 : nowUs;
+    int64_t fromUs = fromS ? fromS * 1000000 : toUs - lastS * 1000000;
+
+    TimeSeriesReader reader(directory);
+    std::vector<std::string> fields = reader.fields(series);
+    if (fields.empty()) {
+        std::fprintf(stderr, "no series %s in %s\n", series.c_str(), directory.c_str());
+        return 1;
+    }
+
+    int64_t startNs = monotonicNs();
+    if (raw) {
+        std::printf("ts_us");
+        for (const std::string& f : fields) std::printf(",%s", f.c_str());
+        std::printf("\n");
+        size_t count = reader.samples(series, fromUs, toUs, [&fields](int64_t timestampUs, const float* values) {
+            std::printf("%lld", static_cast<long long>(timestampUs));
+            for (size_t v = 0; v < fields.size(); v++) std::printf(",%.2f", values[v]);
+            std::printf("\n");
+        });
+        std::fprintf(stderr, "%zu samples in %.3f ms\n", count, (monotonicNs() - startNs) / 1e6);
+    } else {
+        TimeSeriesStats stats[TIMESERIES_MAX_VALUES];
+        size_t count = reader.aggregate(series, fromUs, toUs, stats);
+        double tookMs = (monotonicNs() - startNs) / 1e6;
+        for (size_t v = 0; v < count && v < fields.size(); v++) {
+            std::printf("%-12s %9llu samples  min %9.2f  max %9.2f  mean %9.3f\n", fields[v].c_str(),
+                        static_cast<unsigned long long>(stats[v].count), stats[v].min, stats[v].max, stats[v].mean);
+        }
+        TimeSeriesQueryMetrics m = reader.metrics();
+        std::printf("%.3f ms, %llu segments (%llu with an index file), %llu blocks from their summary, %llu decoded\n", tookMs,
+                    static_cast<unsigned long long>(m.segments), static_cast<unsigned long long>(m.sealed),
+                    static_cast<unsigned long long>(m.summarised), static_cast<unsigned long long>(m.decoded));
+    }
+    return 0;
+}
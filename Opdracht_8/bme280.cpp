@@ -15,6 +15,7 @@
  */
 
 #include "bme280.hpp"
+#include "clock.hpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -46,6 +47,23 @@
 #define BME280_REG_HUM_MSB   0xFD
 #define BME280_REG_HUM_LSB   0xFE
 
+//--> Raw data block layout (burst read from BME280_REG_PRESS_MSB)
+#define BME280_RAW_LEN        8
+#define BME280_RAW_PRESS      0
+#define BME280_RAW_TEMP       3
+#define BME280_RAW_HUM        6
+
+//--> Register settings written in begin()
+#define BME280_CTRL_HUM_VALUE  0x01   // humidity oversampling x1
+#define BME280_CTRL_MEAS_VALUE 0x27   // normal mode, oversampling x1 (temp+press)
+#define BME280_CONFIG_VALUE    0x00   // standby 0.5 ms, filter off
+
+//--> Mode bits in ctrl_meas and measuring bit in status
+#define BME280_MODE_MASK       0x03
+#define BME280_MODE_SLEEP      0x00
+#define BME280_MODE_FORCED     0x01
+#define BME280_STATUS_MEASURING 0x08
+
 //--> Valid ranges
 #define BME280_TEMP_MIN     -40.0f
 #define BME280_TEMP_MAX      85.0f
@@ -83,13 +101,18 @@ bool BME280::begin(uint8_t addr, int bus) {
     readCalibration();
 
     //--> Humidity oversampling x1
-    write8(BME280_REG_CTRL_HUM, 0x01);
+    write8(BME280_REG_CTRL_HUM, BME280_CTRL_HUM_VALUE);
 
     //--> Normal mode, oversampling x1 (temp+press)
-    write8(BME280_REG_CTRL_MEAS, 0x27);
+    ctrlMeas = BME280_CTRL_MEAS_VALUE;
+    write8(BME280_REG_CTRL_MEAS, ctrlMeas);
 
     //--> Config register (standby, filter off)
-    write8(BME280_REG_CONFIG, 0x00);
+    write8(BME280_REG_CONFIG, BME280_CONFIG_VALUE);
+
+    //--> Sensor produces no new data within one conversion period, so cache that long
+    rawValid = false;
+    cacheMaxAge = conversionPeriod(BME280_CTRL_HUM_VALUE, BME280_CTRL_MEAS_VALUE, BME280_CONFIG_VALUE);
 
     return true;
 }
@@ -104,132 +127,152 @@ void BME280::write8(uint8_t reg, uint8_t val) { dev->write8(reg, val); }
 
 // Read calibration data
 void BME280::readCalibration() {
-    dig_T1 = read16_LE(0x88);
-    dig_T2 = readS16_LE(0x8A);
-    dig_T3 = readS16_LE(0x8C);
-    dig_P1 = read16_LE(0x8E);
-    dig_P2 = readS16_LE(0x90);
-    dig_P3 = readS16_LE(0x92);
-    dig_P4 = readS16_LE(0x94);
-    dig_P5 = readS16_LE(0x96);
-    dig_P6 = readS16_LE(0x98);
-    dig_P7 = readS16_LE(0x9A);
-    dig_P8 = readS16_LE(0x9C);
-    dig_P9 = readS16_LE(0x9E);
-
-    dig_H1 = read8(0xA1);
-    dig_H2 = readS16_LE(0xE1);
-    dig_H3 = read8(0xE3);
-    dig_H4 = (read8(0xE4) << 4) | (read8(0xE5) & 0x0F);
-    dig_H5 = (read8(0xE6) << 4) | (read8(0xE5) >> 4);
-    dig_H6 = static_cast<int8_t>(read8(0xE7));
+    auto c = std::make_shared<BME280Calibration>();
+    c->dig_T1 = read16_LE(0x88);
+    c->dig_T2 = readS16_LE(0x8A);
+    c->dig_T3 = readS16_LE(0x8C);
+    c->dig_P1 = read16_LE(0x8E);
+    c->dig_P2 = readS16_LE(0x90);
+    c->dig_P3 = readS16_LE(0x92);
+    c->dig_P4 = readS16_LE(0x94);
+    c->dig_P5 = readS16_LE(0x96);
+    c->dig_P6 = readS16_LE(0x98);
+    c->dig_P7 = readS16_LE(0x9A);
+    c->dig_P8 = readS16_LE(0x9C);
+    c->dig_P9 = readS16_LE(0x9E);
+
+    c->dig_H1 = read8(0xA1);
+    c->dig_H2 = readS16_LE(0xE1);
+    c->dig_H3 = read8(0xE3);
+    c->dig_H4 = (read8(0xE4) << 4) | (read8(0xE5) & 0x0F);
+    c->dig_H5 = (read8(0xE6) << 4) | (read8(0xE5) >> 4);
+    c->dig_H6 = static_cast<int8_t>(read8(0xE7));
+    calibration = c;
+}
+
+//--> Bulk read, compensation is done by the sample when a value is asked for
+BME280Sample BME280::readSample() {
+    const uint8_t* raw = readRawData();
+
+    //--> Raw 20-bit ADC temperature and pressure data, 16-bit humidity data
+    int32_t adc_T = (raw[BME280_RAW_TEMP] << 12) | (raw[BME280_RAW_TEMP + 1] << 4) | (raw[BME280_RAW_TEMP + 2] >> 4);
+    int32_t adc_P = (raw[BME280_RAW_PRESS] << 12) | (raw[BME280_RAW_PRESS + 1] << 4) | (raw[BME280_RAW_PRESS + 2] >> 4);
+    int32_t adc_H = (raw[BME280_RAW_HUM] << 8) | raw[BME280_RAW_HUM + 1];
+
+    return BME280Sample(adc_T, adc_P, adc_H, calibration, rawSequence, rawTime);
 }
 
 //--> Read temperature in Celsius
 float BME280::readTemperature() {
-    //--> Read raw 20-bit ADC temperature data (stored in 3 registers)
-    int32_t adc_T = (read8(BME280_REG_TEMP_MSB) << 12) | (read8(BME280_REG_TEMP_LSB) << 4) | (read8(BME280_REG_TEMP_XLSB) >> 4);
+    return checkedTemperature(readSample());
+}
 
-    //--> First temperature compensation step
-    float var1 = ((adc_T / 16384.0f) - (dig_T1 / 1024.0f)) * dig_T2;
+//--> Read pressure in hpa
+float BME280::readPressure() {
+    //--> t_fine is computed inside the sample, no separate temperature read needed
+    return checkedPressure(readSample());
+}
 
-    //--> Second temperature compensation step
-    float var2 = (((adc_T / 131072.0f) - (dig_T1 / 8192.0f)) *
-                  ((adc_T / 131072.0f) - (dig_T1 / 8192.0f))) * dig_T3;
+//--> Read humidity in %
+float BME280::readHumidity() {
+    return checkedHumidity(readSample());
+}
 
-    //--> Final temperature in Celsius
-    float temp = (var1 + var2) / 5120.0f;
+//--> Temperature of a sample, return last valid if out of range for DRY principle
+float BME280::checkedTemperature(const BME280Sample& sample) {
+    lastTemperature = validOrLast(sample.temperature(), BME280_TEMP_MIN, BME280_TEMP_MAX, lastTemperature);
+    return lastTemperature;
+}
 
-    //--> Return last valid if out of range for DRY principle
-    temp = validOrLast(temp, BME280_TEMP_MIN, BME280_TEMP_MAX, lastTemperature);
-    lastTemperature = temp;
-    return temp;
+//--> Pressure of a sample, return last valid if out of range for DRY principle
+float BME280::checkedPressure(const BME280Sample& sample) {
+    lastPressure = validOrLast(sample.pressure(), BME280_PRESS_MIN, BME280_PRESS_MAX, lastPressure);
+    return lastPressure;
 }
 
-//--> Read temperature and update t_fine (used for pressure/humidity)
-int32_t BME280::updateTFine() {
-    //--> Read raw 20-bit ADC temperature data (stored in 3 registers)
-    int32_t adc_T = (read8(BME280_REG_TEMP_MSB) << 12) | (read8(BME280_REG_TEMP_LSB) << 4) | (read8(BME280_REG_TEMP_XLSB) >> 4);
+//--> Humidity of a sample, return last valid if out of range for DRY principle
+float BME280::checkedHumidity(const BME280Sample& sample) {
+    lastHumidity = validOrLast(sample.humidity(), BME280_HUM_MIN, BME280_HUM_MAX, lastHumidity);
+    return lastHumidity;
+}
 
-    //--> First temperature compensation step
-    float var1 = ((adc_T / 16384.0f) - (dig_T1 / 1024.0f)) * dig_T2;
+//--> Helper function to return last valid reading if current is out of range
+float BME280::validOrLast(float value, float min, float max, float last) {
+    if (std::isnan(value) || value < min || value > max) {
+        return last;
+    }
+    return value;
+}
 
-    //--> Second temperature compensation step
-    float var2 = (((adc_T / 131072.0f) - (dig_T1 / 8192.0f)) *
-                  ((adc_T / 131072.0f) - (dig_T1 / 8192.0f))) * dig_T3;
+//--> Switch to forced mode, the sensor goes to sleep until triggered
+void BME280::setForcedMode() {
+    ctrlMeas = (ctrlMeas & ~BME280_MODE_MASK) | BME280_MODE_SLEEP;
+    write8(BME280_REG_CTRL_MEAS, ctrlMeas);
 
-    //--> Fine temperature (used for pressure/humidity too)
-    int32_t t_fine = static_cast<int32_t>(var1 + var2);
-    return t_fine;
+    //--> Data only changes after a trigger, which also drops the cache
+    rawValid = false;
+    cacheMaxAge = getMeasurementTime();
 }
 
-//--> Read pressure in hpa
-float BME280::readPressure() {
-    //--> Must read temperature first to update t_fine from datasheet
-    int32_t t_fine = updateTFine();
-
-    //--> Raw 20-bit ADC pressure data
-    int32_t adc_P = (read8(BME280_REG_PRESS_MSB) << 12) | (read8(BME280_REG_PRESS_LSB) << 4) | (read8(BME280_REG_PRESS_XLSB) >> 4);
+//--> Start one conversion, results are ready after getMeasurementTime()
+void BME280::triggerConversion() {
+    write8(BME280_REG_CTRL_MEAS, forcedTrigger());
+    rawValid = false;
+}
 
-    //--> Long black magic math from datasheet...
-    int64_t var1, var2, p;
+uint8_t BME280::forcedTrigger() const {
+    return (ctrlMeas & ~BME280_MODE_MASK) | BME280_MODE_FORCED;
+}
 
-    var1 = static_cast<int64_t>(t_fine) - 128000;
-    var2 = var1 * var1 * dig_P6;
-    var2 = var2 + ((var1 * dig_P5) << 17);
-    var2 = var2 + (static_cast<int64_t>(dig_P4) << 35);
-    var1 = ((var1 * var1 * dig_P3) >> 8) + ((var1 * dig_P2) << 12);
-    var1 = ((((int64_t)1 << 47) + var1) * dig_P1) >> 33;
-    if (var1 == 0) return lastPressure;
+//--> True while a conversion is running
+bool BME280::isMeasuring() {
+    return read8(BME280_REG_STATUS) & BME280_STATUS_MEASURING;
+}
 
-    p = 1048576 - adc_P;
-    p = (((p << 31) - var2) * 3125) / var1;
-    var1 = (dig_P9 * (p >> 13) * (p >> 13)) >> 25;
-    var2 = (dig_P8 * p) >> 19;
-    p = ((p + var1 + var2) >> 8) + (dig_P7 << 4);
+//--> Time one conversion takes with the current oversampling
+std::chrono::microseconds BME280::getMeasurementTime() const {
+    return conversionPeriod(BME280_CTRL_HUM_VALUE, forcedTrigger(), BME280_CONFIG_VALUE);
+}
 
-    //--> Convert pressure to hpa
-    float pressure = static_cast<float>(p) / 25600.0f;
+//--> Set how long a raw data block may be reused before the bus is read again
+void BME280::setCacheMaxAge(std::chrono::microseconds maxAge) {
+    cacheMaxAge = maxAge;
+}
 
-    //--> Return last valid if out of range for DRY principle
-    pressure = validOrLast(pressure, BME280_PRESS_MIN, BME280_PRESS_MAX, lastPressure);
-    lastPressure = pressure;
-    return pressure;
+std::chrono::microseconds BME280::getCacheMaxAge() const {
+    return cacheMaxAge;
 }
 
-//--> Read humidity in %
-float BME280::readHumidity() {
-    //--> Must read temperature first to update t_fine
-    int32_t t_fine = updateTFine();
+//--> Burst read all measurement registers at once, or reuse the last block while it is fresh
+const uint8_t* BME280::readRawData() {
+    if (rawValid && monotonicNs() - rawTime < std::chrono::nanoseconds(cacheMaxAge).count()) return rawData;
 
-    //--> Raw 16-bit ADC humidity data
-    int32_t adc_H = (read8(BME280_REG_HUM_MSB) << 8) | read8(BME280_REG_HUM_LSB);
+    dev->readBlock(BME280_REG_PRESS_MSB, rawData, BME280_RAW_LEN);
 
-    //--> Long black magic math from datasheet...
-    int32_t v_x1_u32r = t_fine - 76800;
-    v_x1_u32r = (((((adc_H << 14) - (dig_H4 << 20) - (dig_H5 * v_x1_u32r)) + 16384) >> 15) *
-                 (((((((v_x1_u32r * dig_H6) >> 10) *
-                      (((v_x1_u32r * dig_H3) >> 11) + 32768)) >> 10) + 2097152) *
-                   dig_H2 + 8192) >> 14));
-    v_x1_u32r = v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * dig_H1) >> 4);
+    //--> Stamp the moment the i2c transaction completed, not when the value gets used
+    rawTime = monotonicNs();
+    rawSequence++;
+    rawValid = true;
+    return rawData;
+}
 
-    //--> make sure of valid range
-    if (v_x1_u32r < 0) v_x1_u32r = 0;
-    if (v_x1_u32r > 419430400) v_x1_u32r = 419430400;
+//--> Datasheet chapter 9: t_meas = 1.25 + 2.3*T + (2.3*P + 0.575) + (2.3*H + 0.575) ms, plus t_standby in normal mode
+std::chrono::microseconds BME280::conversionPeriod(uint8_t ctrlHum, uint8_t ctrlMeas, uint8_t config) {
+    //--> Oversampling register code to number of samples (0 = skipped)
+    static const int oversampling[8] = { 0, 1, 2, 4, 8, 16, 16, 16 };
+    //--> Standby register code to microseconds
+    static const int standby[8] = { 500, 62500, 125000, 250000, 500000, 1000000, 10000, 20000 };
 
-    //--> Convert humidity to percentage
-    float humidity = (v_x1_u32r >> 12) / 1024.0f;
+    int osrsT = oversampling[(ctrlMeas >> 5) & 0x07];
+    int osrsP = oversampling[(ctrlMeas >> 2) & 0x07];
+    int osrsH = oversampling[ctrlHum & 0x07];
 
-    //--> Return last valid if out of range for DRY principle
-    humidity = validOrLast(humidity, BME280_HUM_MIN, BME280_HUM_MAX, lastHumidity);
-    lastHumidity = humidity;
-    return humidity;
-}
+    int us = 1250 + 2300 * osrsT;
+    if (osrsP) us += 2300 * osrsP + 575;
+    if (osrsH) us += 2300 * osrsH + 575;
 
-//--> Helper function to return last valid reading if current is out of range
-float BME280::validOrLast(float value, float min, float max, float last) {
-    if (std::isnan(value) || value < min || value > max) {
-        return last;
-    }
-    return value;
+    //--> Forced/sleep mode has no standby, new data only comes when triggered
+    if ((ctrlMeas & 0x03) == 0x03) us += standby[(config >> 5) & 0x07];
+
+    return std::chrono::microseconds(us);
 }
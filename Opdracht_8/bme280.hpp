@@ -10,6 +10,7 @@
 #define BME280_HPP
 
 #include "i2c.hpp"
+#include "bme280_sample.hpp"
 #include <cstdint>
 #include <cmath>
 #include <iostream>
@@ -33,29 +34,50 @@ public:
     float readPressure();
     float readHumidity();
 
+    //--> Range checked values of a sample, last valid value when out of range
+    float checkedTemperature(const BME280Sample& sample);
+    float checkedPressure(const BME280Sample& sample);
+    float checkedHumidity(const BME280Sample& sample);
+
+    //--> Bulk read of all channels, values are compensated lazily by the sample
+    BME280Sample readSample();
+
+    //--> Forced mode, the sensor sleeps and does one conversion per trigger
+    void setForcedMode();
+    void triggerConversion();
+    bool isMeasuring();
+    std::chrono::microseconds getMeasurementTime() const;
+
+    //--> Raw data cache, reads within max age are served from memory (0 disables the cache)
+    void setCacheMaxAge(std::chrono::microseconds maxAge);
+    std::chrono::microseconds getCacheMaxAge() const;
+
 //-> Private functions and variables
 private:
     //--> Pointer to i2c device and address
     std::unique_ptr<I2CDevice> dev;
     uint8_t i2caddress;
 
-    //--> Calibration data (black magic straight from bosch datasheet, stored in sensor at the factory)
-    uint16_t dig_T1;
-    int16_t dig_T2, dig_T3;
-    uint16_t dig_P1;
-    int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
-    uint8_t  dig_H1, dig_H3;
-    int16_t dig_H2, dig_H4, dig_H5;
-    int8_t dig_H6;
-	
-    //--> variable from bosch datasheet
-    //int32_t t_fine;      //removed to improve cohesion/coupling
+    //--> Current ctrl_meas register value
+    uint8_t ctrlMeas = 0;
+
+    //--> Calibration data, shared with every sample that is handed out
+    std::shared_ptr<const BME280Calibration> calibration;
 
     //--> Store last known valid readings
     float lastTemperature = 20.0;
     float lastHumidity = 50.0;
     float lastPressure = 1000.0;
 
+    //--> Last raw data block (press, temp, hum registers), CLOCK_MONOTONIC ns when the read completed
+    uint8_t rawData[8];
+    bool rawValid = false;
+    int64_t rawTime = 0;
+    std::chrono::microseconds cacheMaxAge{0};
+
+    //--> Counts every raw block read from the bus
+    uint64_t rawSequence = 0;
+
     //--> I2C helper functions for Wirelibrarey
     uint8_t  read8(uint8_t reg);
     uint16_t read16(uint8_t reg);
@@ -70,8 +92,17 @@ private:
     //--> Helper function for DRY principle
     float validOrLast(float value, float min, float max, float last);
 
-    //--> Helper function for cohesiuon/coupling
-    int32_t updateTFine();
+    //--> Return raw data block, only touches the bus when the cache is stale
+    const uint8_t* readRawData();
+
+    //--> Standby + measurement time for the given register settings
+    static std::chrono::microseconds conversionPeriod(uint8_t ctrlHum, uint8_t ctrlMeas, uint8_t config);
+
+    //--> ctrl_meas value that starts one forced conversion
+    uint8_t forcedTrigger() const;
+
+    //--> Array triggers all its sensors in one bus transaction
+    friend class BME280Array;
 };
 
 #endif //--> BME280_HPP
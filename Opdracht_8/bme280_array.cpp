@@ -0,0 +1,158 @@
+/*!
+ * \file      bme280_array.cpp
+ * \brief     Phase aligned sampling of several BME280 sensors
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "bme280_array.hpp"
+#include "clock.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+//--> BME280 control register that holds the mode bits
+#define BME280_REG_CTRL_MEAS 0xF4
+
+//--> Add a sensor and sort it under its bus
+void BME280Array::add(BME280& sensor) {
+    size_t index = sensors.size();
+    sensors.push_back(&sensor);
+
+    int bus = sensor.dev->getBus();
+    for (auto& group : busses) {
+        if (sensors[group.front()]->dev->getBus() == bus) {
+            group.push_back(index);
+            return;
+        }
+    }
+    busses.push_back({ index });
+}
+
+//--> Destructor
+BME280Array::~BME280Array() {
+    stop();
+}
+
+//--> All sensors sleep until triggered, readers wait for the first round
+void BME280Array::begin() {
+    stop();
+    for (BME280* sensor : sensors) sensor->setForcedMode();
+
+    results.assign(busses.size(), {});
+    resultValid.assign(busses.size(), {});
+    running = true;
+    for (size_t b = 0; b < busses.size(); b++) readers.emplace_back(&BME280Array::run, this, b);
+}
+
+//--> Wake the readers to stop and wait for them
+void BME280Array::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        running = false;
+    }
+    wake.notify_all();
+    for (std::thread& reader : readers) reader.join();
+    readers.clear();
+}
+
+//--> One transaction on the bus, the kernel sends a message per sensor with repeated starts
+void BME280Array::triggerBus(const std::vector<size_t>& bus) {
+    std::vector<I2CDevice*> devices;
+    std::vector<uint8_t> values;
+    for (size_t i : bus) {
+        devices.push_back(sensors[i]->dev.get());
+        values.push_back(sensors[i]->forcedTrigger());
+    }
+
+    try {
+        I2CDevice::writeCombined(devices, BME280_REG_CTRL_MEAS, values);
+        for (size_t i : bus) sensors[i]->rawValid = false;
+    } catch (const std::runtime_error&) {
+        //--> Adapter without combined transfers, fall back to back-to-back writes
+        for (size_t i : bus) sensors[i]->triggerConversion();
+    }
+}
+
+//--> Trigger round, wait, parallel read back
+BME280SampleSet BME280Array::sample() {
+    BME280SampleSet set;
+    if (sensors.empty()) return set;
+    if (readers.size() != busses.size()) throw std::runtime_error("BME280Array::sample() before begin()");
+
+    //--> Trigger round, as tight as possible
+    int64_t start = monotonicNs();
+    for (const auto& bus : busses) triggerBus(bus);
+    int64_t end = monotonicNs();
+    set.triggerTime = start + (end - start) / 2;
+    set.triggerSkew = end - start;
+
+    //--> Wait for the slowest sensor, a sensor still busy at twice that time is given up on
+    std::chrono::microseconds wait(0);
+    for (BME280* sensor : sensors) wait = std::max(wait, sensor->getMeasurementTime());
+    std::this_thread::sleep_for(wait);
+
+    //--> Hand the round to the readers, reads on the same bus are serialized by the bus anyway
+    std::unique_lock<std::mutex> guard(lock);
+    deadline = end + 2 * std::chrono::nanoseconds(wait).count();
+    pending = busses.size();
+    failure = nullptr;
+    round++;
+    wake.notify_all();
+    done.wait(guard, [this] { return pending == 0; });
+    if (failure) std::rethrow_exception(failure);
+
+    //--> Put results back in the order the sensors were added
+    std::vector<const BME280Sample*> ordered(sensors.size(), nullptr);
+    set.valid.assign(sensors.size(), false);
+    for (size_t b = 0; b < busses.size(); b++) {
+        for (size_t k = 0; k < busses[b].size(); k++) {
+            ordered[busses[b][k]] = &results[b][k];
+            set.valid[busses[b][k]] = resultValid[b][k];
+        }
+    }
+    set.samples.reserve(sensors.size());
+    for (const BME280Sample* s : ordered) set.samples.push_back(*s);
+    return set;
+}
+
+//--> Sleep until a round starts, read the bus, report back
+void BME280Array::run(size_t bus) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        wake.wait(guard, [this, seen] { return !running || round != seen; });
+        if (!running) return;
+        seen = round;
+
+        guard.unlock();
+        std::exception_ptr error;
+        try {
+            readBus(bus);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        guard.lock();
+
+        if (error && !failure) failure = error;
+        if (--pending == 0) done.notify_one();
+    }
+}
+
+//--> Poll each sensor of the bus until it is done or the deadline passed, then read it
+void BME280Array::readBus(size_t bus) {
+    std::vector<BME280Sample>& out = results[bus];
+    std::vector<bool>& valid = resultValid[bus];
+    out.clear();
+    valid.clear();
+    for (size_t i : busses[bus]) {
+        bool ready = !sensors[i]->isMeasuring();
+        while (!ready && monotonicNs() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            ready = !sensors[i]->isMeasuring();
+        }
+        if (ready) out.push_back(sensors[i]->readSample());
+        else out.push_back(BME280Sample(0, 0, 0, sensors[i]->calibration));
+        valid.push_back(ready);
+    }
+}
@@ -0,0 +1,87 @@
+/*!
+ * \file      bme280_array.hpp
+ * \brief     Phase aligned sampling of several BME280 sensors
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * All sensors run in forced mode. A sample set starts with one combined i2c
+ * transaction per bus that triggers every sensor on that bus, then the results
+ * are read back in parallel by one reader thread per bus. begin() starts those
+ * threads, they sleep between sets. The time spread of the trigger round is
+ * reported as skew with every set.
+ *
+ * A sensor that is still converting twice the conversion time after the
+ * trigger round is not read: its sample in the set is empty and marked
+ * invalid, so one hanging sensor cannot stall the array.
+ *
+ */
+
+#ifndef BME280_ARRAY_HPP
+#define BME280_ARRAY_HPP
+
+#include "bme280.hpp"
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//--> One synchronized measurement of all sensors in the array
+struct BME280SampleSet {
+    std::vector<BME280Sample> samples;  // same order as the sensors were added
+    std::vector<bool> valid;            // per sample, false when the sensor missed the deadline (empty sample)
+    int64_t triggerTime = 0;            // CLOCK_MONOTONIC ns in the middle of the trigger round
+    int64_t triggerSkew = 0;            // ns between the first trigger starting and the last one completing
+};
+
+//--> Group of sensors that are sampled at the same moment
+class BME280Array {
+
+//-> Public functions
+public:
+    //--> Destructor, stops the reader threads
+    ~BME280Array();
+
+    //--> Add a sensor that already passed begin(), call before begin()
+    void add(BME280& sensor);
+
+    //--> Put all sensors in forced mode and start a reader thread per bus
+    void begin();
+
+    //--> Trigger all sensors, wait for the conversion and read them back, throws when a read fails
+    BME280SampleSet sample();
+
+//-> Private functions and variables
+private:
+    std::vector<BME280*> sensors;
+
+    //--> Sensor indexes per i2c bus
+    std::vector<std::vector<size_t>> busses;
+
+    //--> Reader threads, one per bus, woken for every set
+    std::vector<std::thread> readers;
+    std::mutex lock;
+    std::condition_variable wake;           // new round or stop
+    std::condition_variable done;           // a bus finished its round
+    uint64_t round = 0;
+    size_t pending = 0;                     // busses still reading this round
+    bool running = false;
+    int64_t deadline = 0;                   // CLOCK_MONOTONIC ns after which a busy sensor is skipped
+    std::vector<std::vector<BME280Sample>> results;     // per bus, in bus order
+    std::vector<std::vector<bool>> resultValid;
+    std::exception_ptr failure;             // first read error of this round
+
+    //--> Trigger all sensors on one bus in a single transaction
+    void triggerBus(const std::vector<size_t>& bus);
+
+    //--> Reader thread body and one round of it
+    void run(size_t bus);
+    void readBus(size_t bus);
+
+    //--> Stop and join the reader threads
+    void stop();
+};
+
+#endif //--> BME280_ARRAY_HPP
@@ -0,0 +1,105 @@
+/*!
+ * \file      bme280_sample.cpp
+ * \brief     One BME280 measurement with lazy compensation
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \note Datasheet: https://www.bosch-sensortec.com/media/boschsensortec/downloads/datasheets/bst-bme280-ds002.pdf
+ * All the complex formulas came straight from the Bosch datasheet.
+ *
+ */
+
+#include "bme280_sample.hpp"
+#include <cmath>
+#include <utility>
+
+//--> First and second temperature compensation step, t_fine and °C are both derived from this
+float BME280Calibration::fineTemperature(int32_t adc_T) const {
+    //--> First temperature compensation step
+    float var1 = ((adc_T / 16384.0f) - (dig_T1 / 1024.0f)) * dig_T2;
+
+    //--> Second temperature compensation step
+    float var2 = (((adc_T / 131072.0f) - (dig_T1 / 8192.0f)) *
+                  ((adc_T / 131072.0f) - (dig_T1 / 8192.0f))) * dig_T3;
+
+    return var1 + var2;
+}
+
+//--> Pressure in hpa
+float BME280Calibration::pressure(int32_t adc_P, int32_t t_fine) const {
+    //--> Long black magic math from datasheet...
+    int64_t var1, var2, p;
+
+    var1 = static_cast<int64_t>(t_fine) - 128000;
+    var2 = var1 * var1 * dig_P6;
+    var2 = var2 + ((var1 * dig_P5) << 17);
+    var2 = var2 + (static_cast<int64_t>(dig_P4) << 35);
+    var1 = ((var1 * var1 * dig_P3) >> 8) + ((var1 * dig_P2) << 12);
+    var1 = ((((int64_t)1 << 47) + var1) * dig_P1) >> 33;
+    if (var1 == 0) return NAN;
+
+    p = 1048576 - adc_P;
+    p = (((p << 31) - var2) * 3125) / var1;
+    var1 = (dig_P9 * (p >> 13) * (p >> 13)) >> 25;
+    var2 = (dig_P8 * p) >> 19;
+    p = ((p + var1 + var2) >> 8) + (dig_P7 << 4);
+
+    //--> Convert pressure to hpa
+    return static_cast<float>(p) / 25600.0f;
+}
+
+//--> Humidity in %
+float BME280Calibration::humidity(int32_t adc_H, int32_t t_fine) const {
+    //--> Long black magic math from datasheet...
+    int32_t v_x1_u32r = t_fine - 76800;
+    v_x1_u32r = (((((adc_H << 14) - (dig_H4 << 20) - (dig_H5 * v_x1_u32r)) + 16384) >> 15) *
+                 (((((((v_x1_u32r * dig_H6) >> 10) *
+                      (((v_x1_u32r * dig_H3) >> 11) + 32768)) >> 10) + 2097152) *
+                   dig_H2 + 8192) >> 14));
+    v_x1_u32r = v_x1_u32r - (((((v_x1_u32r >> 15) * (v_x1_u32r >> 15)) >> 7) * dig_H1) >> 4);
+
+    //--> make sure of valid range
+    if (v_x1_u32r < 0) v_x1_u32r = 0;
+    if (v_x1_u32r > 419430400) v_x1_u32r = 419430400;
+
+    //--> Convert humidity to percentage
+    return (v_x1_u32r >> 12) / 1024.0f;
+}
+
+//--> Constructor
+BME280Sample::BME280Sample(int32_t adcT, int32_t adcP, int32_t adcH, std::shared_ptr<const BME280Calibration> calibration,
+                           uint64_t sequence, int64_t timestamp)
+    : adc_T(adcT), adc_P(adcP), adc_H(adcH), calib(std::move(calibration)), seq(sequence), monoNs(timestamp) { }
+
+//--> Compute t_fine once, pressure and humidity reuse it
+int32_t BME280Sample::updateTFine() const {
+    if (!(computed & HAS_T_FINE)) {
+        fine = calib->fineTemperature(adc_T);
+        computed |= HAS_T_FINE;
+    }
+    return static_cast<int32_t>(fine);
+}
+
+//--> Temperature in Celsius
+float BME280Sample::temperature() const {
+    updateTFine();
+    return fine / 5120.0f;
+}
+
+//--> Pressure in hpa
+float BME280Sample::pressure() const {
+    if (!(computed & HAS_PRESSURE)) {
+        press = calib->pressure(adc_P, updateTFine());
+        computed |= HAS_PRESSURE;
+    }
+    return press;
+}
+
+//--> Humidity in %
+float BME280Sample::humidity() const {
+    if (!(computed & HAS_HUMIDITY)) {
+        hum = calib->humidity(adc_H, updateTFine());
+        computed |= HAS_HUMIDITY;
+    }
+    return hum;
+}
@@ -0,0 +1,78 @@
+/*!
+ * \file      bme280_sample.hpp
+ * \brief     One BME280 measurement with lazy compensation
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * A sample only holds the raw ADC values and a shared reference to the factory
+ * calibration. Temperature, pressure and humidity are calculated the first time
+ * they are asked for and then remembered, so a consumer that only wants pressure
+ * never pays for the humidity math.
+ *
+ */
+
+#ifndef BME280_SAMPLE_HPP
+#define BME280_SAMPLE_HPP
+
+#include <cstdint>
+#include <memory>
+
+//--> Calibration data (black magic straight from bosch datasheet, stored in sensor at the factory)
+struct BME280Calibration {
+    uint16_t dig_T1;
+    int16_t dig_T2, dig_T3;
+    uint16_t dig_P1;
+    int16_t dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+    uint8_t  dig_H1, dig_H3;
+    int16_t dig_H2, dig_H4, dig_H5;
+    int8_t dig_H6;
+
+    //--> Compensation formulas from the datasheet, NAN when the formula has no result
+    float fineTemperature(int32_t adc_T) const;
+    float pressure(int32_t adc_P, int32_t t_fine) const;
+    float humidity(int32_t adc_H, int32_t t_fine) const;
+};
+
+//--> Raw measurement, physical values are computed on first access
+class BME280Sample {
+
+//-> Public functions
+public:
+    //--> Constructor
+    BME280Sample(int32_t adcT, int32_t adcP, int32_t adcH, std::shared_ptr<const BME280Calibration> calibration,
+                 uint64_t sequence = 0, int64_t timestamp = 0);
+
+    //--> Compensated values (°C, hPa, %)
+    float temperature() const;
+    float pressure() const;
+    float humidity() const;
+
+    //--> Raw ADC values
+    int32_t rawTemperature() const { return adc_T; }
+    int32_t rawPressure() const { return adc_P; }
+    int32_t rawHumidity() const { return adc_H; }
+
+    //--> Per sensor sequence number and CLOCK_MONOTONIC ns of the i2c read, samples served from cache share both
+    uint64_t sequence() const { return seq; }
+    int64_t timestamp() const { return monoNs; }
+
+//-> Private functions and variables
+private:
+    int32_t adc_T, adc_P, adc_H;
+    std::shared_ptr<const BME280Calibration> calib;
+    uint64_t seq;
+    int64_t monoNs;
+
+    //--> Memoized results, flags tell which ones are already computed
+    enum : uint8_t { HAS_T_FINE = 1, HAS_PRESSURE = 2, HAS_HUMIDITY = 4 };
+    mutable uint8_t computed = 0;
+    mutable float fine = 0.0f;
+    mutable float press = 0.0f;
+    mutable float hum = 0.0f;
+
+    //--> t_fine is shared by temperature, pressure and humidity so it is only computed once
+    int32_t updateTFine() const;
+};
+
+#endif //--> BME280_SAMPLE_HPP
@@ -11,11 +11,12 @@
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <linux/i2c-dev.h>
+#include <linux/i2c.h>
 #include <stdexcept>
 #include <iostream>
 
 //--> Constructor
-I2CDevice::I2CDevice(int bus, uint8_t address) : addr(address) {
+I2CDevice::I2CDevice(int busNumber, uint8_t address) : bus(busNumber), addr(address) {
     std::string filename = "/dev/i2c-" + std::to_string(bus);
     file = open(filename.c_str(), O_RDWR);
     if (file < 0) throw std::runtime_error("Cannot open I2C bus: " + filename);
@@ -65,3 +66,32 @@ void I2CDevice::write8(uint8_t reg, uint8_t value) {
     uint8_t buf[2] = { reg, value };
     if (write(file, buf, 2) != 2) throw std::runtime_error("I2C write failed (write8)");
 }
+
+//--> burst read len bytes, register pointer auto increments on the sensor
+void I2CDevice::readBlock(uint8_t reg, uint8_t* buf, size_t len) {
+    if (write(file, &reg, 1) != 1) throw std::runtime_error("I2C write failed (readBlock)");
+    if (read(file, buf, len) != static_cast<ssize_t>(len)) throw std::runtime_error("I2C read failed (readBlock)");
+}
+
+//--> one I2C_RDWR ioctl with a message per device, the kernel sends them with repeated starts in between
+void I2CDevice::writeCombined(const std::vector<I2CDevice*>& devices, uint8_t reg, const std::vector<uint8_t>& values) {
+    if (devices.empty()) return;
+    if (values.size() != devices.size()) throw std::runtime_error("I2C combined write needs one value per device");
+
+    std::vector<uint8_t> bufs(devices.size() * 2);
+    std::vector<i2c_msg> msgs(devices.size());
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (devices[i]->bus != devices[0]->bus) throw std::runtime_error("I2C combined write across different busses");
+        bufs[i * 2] = reg;
+        bufs[i * 2 + 1] = values[i];
+        msgs[i].addr = devices[i]->addr;
+        msgs[i].flags = 0;
+        msgs[i].len = 2;
+        msgs[i].buf = &bufs[i * 2];
+    }
+
+    i2c_rdwr_ioctl_data data;
+    data.msgs = msgs.data();
+    data.nmsgs = msgs.size();
+    if (ioctl(devices[0]->file, I2C_RDWR, &data) < 0) throw std::runtime_error("I2C combined write failed (writeCombined)");
+}
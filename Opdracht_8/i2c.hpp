@@ -10,7 +10,9 @@
 #define I2C_HPP
 
 #include <cstdint>
+#include <cstddef>
 #include <string>
+#include <vector>
 
 //--> i2c class
 class I2CDevice {
@@ -31,9 +33,20 @@ public:
     int16_t  readS16_LE(uint8_t reg);
     void     write8(uint8_t reg, uint8_t value);
 
+    //--> Burst read of len bytes starting at reg (one i2c transaction)
+    void     readBlock(uint8_t reg, uint8_t* buf, size_t len);
+
+    //--> Write one register on several devices of the same bus in one combined transaction
+    static void writeCombined(const std::vector<I2CDevice*>& devices, uint8_t reg, const std::vector<uint8_t>& values);
+
+    //--> Bus number and device address
+    int      getBus() const { return bus; }
+    uint8_t  getAddress() const { return addr; }
+
 //--> Global variables
 private:
     int file;
+    int bus;
     uint8_t addr;
 };
 
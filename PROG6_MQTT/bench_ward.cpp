@@ -0,0 +1,126 @@
+/*!
+ * \file      bench_ward.cpp
+ * \brief     Benchmark of the multi-patient ward engine
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Runs the ward ticks back to back through a LoopbackTransport
+ * (common/loopback_transport.hpp), so every payload is copied into a
+ * message, queued, matched against the subscriptions and handed to a
+ * subscriber that reads it, like the trainee monitor would. Commands take
+ * the same way back: the instructor publishes on ward/bed-001/change/...
+ * and the ward gets them through its subscription on ward/+/change/#.
+ *
+ * Two setups, both at the default rates (vitals every 5 s, waveform frames
+ * every 200 ms):
+ *
+ *   one core          the tick thread also delivers (poll() after every
+ *                     tick), wall time per simulated second
+ *   delivery thread   the loopback delivers on its own thread, cpu time of
+ *                     the whole process per simulated second
+ *
+ * Beds per core is the number of beds whose 200 ms ticks, publishing
+ * included, fit in one core. The broker and the network are still not in
+ * it: with paho every message also costs a socket write.
+ *
+ * command used to compile:  g++ -O2 -std=c++17 bench_ward.cpp ward.cpp waveform.cpp ../common/telemetry_codec.cpp ../common/loopback_transport.cpp -I../common -o bench_ward -pthread  then to run: ./bench_ward [patients]
+ */
+
+#include "ward.hpp"
+#include "clock.hpp"
+#include "loopback_transport.hpp"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+const int SIMULATED_SECONDS = 60;
+
+//--> Keeps the compiler from optimising the work away
+static size_t sink = 0;
+
+//--> Cpu time of all threads of this process in ns
+static int64_t processCpuNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//--> Result of one ward setup
+struct WardRun {
+    double cores;               // cores busy per simulated second
+    int64_t maxTickUs;          // slowest tick, publishing included
+    uint64_t messages;          // sent by the ward
+    uint64_t received;          // seen by the subscriber
+    uint64_t applied;           // commands that made it back to the ward
+};
+
+//--> One ward setup through the loopback, threaded selects the delivery thread
+WardRun run(size_t patients, bool waveforms, PayloadFormat format, bool threaded) {
+    WardOptions options;
+    options.patients = patients;
+    options.waveforms = waveforms;
+    options.format = format;
+    Ward ward(options, 1760000000000000LL);
+
+    //--> The ward subscribes to its commands, the monitor to everything it sends
+    LoopbackTransport transport(threaded);
+    uint64_t received = 0;
+    transport.subscribe(Ward::COMMAND_FILTER, 1);
+    transport.setMessageHandler([&ward](std::string_view topic, std::string_view payload) { ward.receive(topic, payload); });
+    transport.attach("ward/+/current/#", [&received](std::string_view topic, std::string_view payload) {
+        sink += topic.size() + static_cast<uint8_t>(payload.empty() ? 0 : payload[payload.size() / 2]);
+        received++;
+    });
+    transport.start();
+
+    //--> Without a delivery thread the queue is emptied before it fills up
+    size_t pending = 0;
+    Ward::Send send = [&](const std::string& topic, std::string_view payload, int qos) {
+        transport.publish(topic, std::string(payload), qos);
+        if (!threaded && ++pending == LoopbackTransport::QUEUE_SIZE / 2) {
+            transport.poll();
+            pending = 0;
+        }
+    };
+
+    int ticks = static_cast<int>(SIMULATED_SECONDS * 1000 / options.tick.count());
+    int64_t startNs = threaded ? processCpuNs() : monotonicNs();
+    for (int i = 0; i < ticks; i++) {
+        //--> A command now and then, like an instructor changing a bed
+        if (i % 5 == 0) transport.publish("ward/bed-001/change/heartbeat", i % 10 ? "80" : "120", 1);
+        ward.tick(send);
+        if (!threaded) {
+            transport.poll();
+            pending = 0;
+        }
+    }
+    transport.stop();
+    int64_t usedNs = (threaded ? processCpuNs() : monotonicNs()) - startNs;
+
+    WardMetrics m = ward.metrics();
+    return WardRun{usedNs / 1e9 / SIMULATED_SECONDS, m.maxTickUs, m.messages, received, m.applied};
+}
+
+//--> One block of output
+static void print(const char* title, size_t patients, const WardRun& r) {
+    std::cout << "  " << title << std::endl;
+    std::cout << "    core usage:        " << r.cores * 100.0 << " %" << std::endl;
+    std::cout << "    max beds per core: " << static_cast<size_t>(patients / r.cores) << std::endl;
+    std::cout << "    slowest tick:      " << r.maxTickUs << " us of 200000" << std::endl;
+    std::cout << "    messages:          " << r.messages << " sent, " << r.received << " received, "
+              << r.applied << " commands applied" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t patients = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 200;
+
+    std::cout << patients << " beds, vitals json + binary every 5 s" << std::endl;
+    print("one core", patients, run(patients, false, PayloadFormat::Both, false));
+    print("delivery thread", patients, run(patients, false, PayloadFormat::Both, true));
+
+    std::cout << patients << " beds, plus ecg/pleth/resp frames every 200 ms" << std::endl;
+    print("one core", patients, run(patients, true, PayloadFormat::Both, false));
+    print("delivery thread", patients, run(patients, true, PayloadFormat::Both, true));
+    return sink == 0;
+}
@@ -0,0 +1,51 @@
+/*!
+ * \file      bench_waveform.cpp
+ * \brief     Benchmark of the waveform generator
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Generates and encodes one hour of ECG (250 Hz), pleth and respiration
+ * (125 Hz) for one patient as fast as possible and prints the time per frame
+ * and the share of one core that real-time generation would take.
+ *
+ * command used to compile:  g++ -O2 -std=c++17 bench_waveform.cpp waveform.cpp ../common/telemetry_codec.cpp -I../common -o bench_waveform  then to run: ./bench_waveform
+ */
+
+#include "waveform.hpp"
+#include <chrono>
+#include <iostream>
+
+const int SIMULATED_SECONDS = 3600;
+
+//--> Keeps the compiler from optimising the work away
+static size_t sink = 0;
+
+int main() {
+    WaveformGenerator generator(1760000000000000LL);
+    WaveformFrame frames[WAVE_COUNT];
+    uint8_t payload[WAVEFORM_HEADER_SIZE + 2 * WAVEFORM_MAX_SAMPLES];
+
+    double frameSeconds = std::chrono::duration<double>(generator.framePeriod()).count();
+    int frameCount = static_cast<int>(SIMULATED_SECONDS / frameSeconds);
+    size_t samples = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frameCount; i++) {
+        //--> Heart rate ramps up and down so the smoothing is part of the work
+        float heartRate = 60.0f + 60.0f * ((i / 300) % 2);
+        generator.generate({heartRate, 16.0f}, frames);
+
+        for (const WaveformFrame& frame : frames) {
+            sink += encodeWaveform(payload, sizeof(payload), frame);
+            samples += frame.count;
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::cout << "frames:          " << frameCount << " x " << WAVE_COUNT << " waves, " << samples << " samples" << std::endl;
+    std::cout << "per frame set:   " << elapsed.count() / frameCount * 1e6 << " us" << std::endl;
+    std::cout << "per sample:      " << elapsed.count() / samples * 1e9 << " ns" << std::endl;
+    std::cout << "core usage:      " << elapsed.count() / SIMULATED_SECONDS * 100.0 << " % of one core per patient" << std::endl;
+    return sink == 0;
+}
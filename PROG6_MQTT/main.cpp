@@ -10,170 +10,447 @@
 * explination of how to use my example mpdule for the prog6 assignment: 
 *
 * this module acts as an mqtt communicator that updates the current values based on received mqtt commands over the REMOTE_TOPIC.
-* The current values are stored in an atomic struct called vitals, (this can also be an external storage by Finn) which allows safe concurrent access from both the main loop and the mqtt callback without race condiotions
-* The main loop reads the current values from the vitals struct, displays them, and publishes them to the TOPIC every 5 seconds.
-* The mqtt callback listens for messages on the REMOTE_TOPIC and updates the corresponding values in the vitals struct when a message is received.
+* The current values are stored in a plain struct called vitals (this can also be an external storage by Finn). only the main loop touches it: commands and scenario values are applied at the start of a tick and everything sent in that tick is read after that, so a record never mixes values from before and after an update and no lock is needed
+* The main loop runs every 200 ms, it reads the current values from the vitals struct, displays them, and publishes them to the TOPIC every 5 seconds.
+* The transport (common/transport.hpp) listens for messages on the REMOTE_TOPIC, parses them and puts them in a lock-free queue (common/mpsc_queue.hpp) without printing or waiting. the main loop applies the queued commands to the vitals struct at the start of every tick, queue depth and apply latency are published on TOPIC + "/metrics".
 * the trainee monitor should only have to listen on the TOPIC using an callback. the instructor panel can publish to the REMOTE_TOPIC to change the values.
 * the Scenario editor of the other group can also be used to publish to the REMOTE_TOPIC to change the values and look at TOPIC to see the current values
 *
-* command used to compile:  g++ main.cpp -o mqtt -lpaho-mqttpp3 -lpaho-mqtt3as -pthread  then to run: ./mqtt
+* a command is a plain number on "change/<value name>", for example 36.6 on change/bodytemperature. the value name is looked up in a perfect hash table the compiler builds (common/topic_router.hpp), commands on unknown names are counted in the metrics.
+*
+* every published record carries a sequence number (seq) and the unix time in us at which the values were read (ts_us), so the monitor can spot lost messages and measure latency.
+*
+* with --format binary (or both) the values are also sent as a packed binary record on TOPIC + "/bin", see common/telemetry_codec.hpp for the layout and decoder.
+*
+* with --waveforms the monitor also gets ECG (250 Hz), pleth and respiration (125 Hz) waveforms that follow the heartbeat and breathspeed, sent every 200 ms as binary frames on TOPIC + "/wave/ecg", "/wave/pleth" and "/wave/resp", see waveform.hpp for the layout. bench_waveform.cpp measures the generation cost.
+*
+* with --scenario <file> the values follow a training scenario (see scenario.hpp for the format and scenarios/sepsis.scn for an example) and the events in it are sent as text on TOPIC + "/event".
+* --warp N plays it N times faster than real time, --warp 0 as fast as the broker takes it, so a 30 minute scenario runs through in seconds for regression and load tests.
+* every tick is still 200 ms of scenario time, so the records and waveform frames come out the same at any speed and ts_us is scenario time (start of the run + time in the scenario). the program stops at the end of the scenario.
+*
+* alarms are detected on the monitor itself by a small rule engine (common/alarm_engine.hpp) that checks the vitals every tick: thresholds with hysteresis, rate of change and a minimum duration, see DEFAULT_ALARM_RULES or load your own with --rules <file>.
+* raised and cleared alarms go out right away with QoS1 on TOPIC + "/alarm/<rule name>", the regular records are sent with QoS0 so the broker spends its effort on the alarms.
+*
+* for a whole ward in one process see ward_main.cpp: N beds with their own topics below ward/bed-NNN/ on one mqtt connection and one 200 ms loop, bench_ward.cpp measures how many beds one core can run.
+*
+* with --loopback nothing goes over the network: the messages go through an in-process lock-free queue (common/loopback_transport.hpp) to a stand-in monitor that counts them, so the whole program runs in a test without a broker, for example --loopback --scenario scenarios/sepsis.scn --warp 0 --waveforms.
+*
+* the connection is kept up by common/connection_manager on its own thread (inside common/paho_transport): after a lost connection it reconnects with backoff, resumes the session and subscribes to REMOTE_TOPIC again. while offline the loop keeps running and skips publishing. publishing never waits for the broker ack, at most MAX_IN_FLIGHT messages wait for one (common/inflight_publisher.hpp).
+*
+* command used to compile:  g++ main.cpp waveform.cpp scenario.cpp ../common/telemetry_codec.cpp ../common/connection_manager.cpp ../common/paho_transport.cpp ../common/inflight_publisher.cpp ../common/spool.cpp ../common/topic_aliases.cpp ../common/loopback_transport.cpp ../common/alarm_engine.cpp -I../common -o mqtt -lpaho-mqttpp3 -lpaho-mqtt3as -pthread  then to run: ./mqtt [--format json|binary|both] [--waveforms] [--scenario file [--warp N]] [--rules file] [--loopback]
 */
 
 #include <iostream>
 #include <thread>
 #include <chrono>
-#include <sstream>
 #include <atomic>
 #include <cctype>
+#include <charconv>
+#include <cstring>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+#include <string_view>
 #include <mqtt/async_client.h>
+#include "clock.hpp"
+#include "json_writer.hpp"
+#include "telemetry_codec.hpp"
+#include "topic_router.hpp"
+#include "mpsc_queue.hpp"
+#include "waveform.hpp"
+#include "scenario.hpp"
+#include "alarm_engine.hpp"
+#include "paho_transport.hpp"
+#include "loopback_transport.hpp"
 
 //--> mqtt setup
 const std::string SERVER_ADDRESS{"tcp://192.168.50.95:1883"};   // change to "tcp://127.0.0.1:1883" when using local broker 
 const std::string CLIENT_ID{"WIETSE-PI"};                       // unique client id
 const std::string TOPIC{"current"};                             // topic wich broadcats the current values
+const std::string BINARY_TOPIC{TOPIC + TELEMETRY_BINARY_SUFFIX};  // same values as packed binary record
+const std::string METRICS_TOPIC{TOPIC + "/metrics"};            // command queue metrics
+const std::string WAVE_TOPIC{TOPIC + "/wave/"};                 // + ecg, pleth or resp, binary waveform frames
+const std::string EVENT_TOPIC{TOPIC + "/event"};                // scenario events as text
+const std::string ALARM_TOPIC{TOPIC + "/alarm/"};               // + rule name, alarm raised or cleared
 const std::string REMOTE_TOPIC{"change/#"};                     // topic used to change the cucrent values
+const std::string_view REMOTE_PREFIX{"change/"};                // part of REMOTE_TOPIC before the value name
 const int QOS = 1;                                              // quality of service             
+const int TELEMETRY_QOS = 0;                                    // regular records, the next one follows in 5 s
+const int ALARM_QOS = 1;                                        // alarms have to arrive
+const size_t MAX_IN_FLIGHT = 64;                                // messages waiting for their ack, then the policy decides
+
+//--> loop timing, commands and waveform frames every tick, the vitals record every VITALS_EVERY ticks (5 s)
+const auto TICK = std::chrono::milliseconds(200);
+const int VITALS_EVERY = 25;
 
 //--> mqtt authentication
 const std::string MQTT_USERNAME{"school"};
 const std::string MQTT_PASSWORD{"Han@2025!"};
 
-// --> Use of atomic to allow safe updates from callback
+// --> Current values, one plain record so a group of changes is one update
 struct VitalSigns {
-    std::atomic<float> heartBeat{72.0f};        // beats per minute
-    std::atomic<float> bloodPressure{120.0f};   // mmHg
-    std::atomic<float> bloodOxygen{98.0f};      // spo2 %
-    std::atomic<float> breathSpeed{16.0f};      // breaths per minute
-    std::atomic<float> bodyTemperature{36.8f};  // °C
+    float heartBeat = 72.0f;        // beats per minute
+    float bloodPressure = 120.0f;   // mmHg
+    float bloodOxygen = 98.0f;      // spo2 %
+    float breathSpeed = 16.0f;      // breaths per minute
+    float bodyTemperature = 36.8f;  // °C
 };
 
-// Global vitals instance
+// Global vitals instance, only used on the main loop thread (the transport thread only queues commands)
 VitalSigns vitals;
 
 
+// payload fields, key and decimals
+inline constexpr JsonField VITALS_FIELDS[] = {
+    {"seq", 0}, {"ts_us", 0}, {"heartbeat", 1}, {"bloodpressure", 1}, {"bloodoxygen", 1}, {"breathspeed", 1}, {"bodytemperature", 1}
+};
+inline constexpr JsonField ALARM_FIELDS[] = {
+    {"active", 0}, {"value", 2}, {"limit", 2}, {"ts_us", 0}
+};
+inline constexpr JsonField COMMAND_METRICS_FIELDS[] = {
+    {"queue_depth", 0}, {"queue_max_depth", 0}, {"applied", 0}, {"dropped", 0}, {"unknown", 0}, {"invalid", 0},
+    {"apply_latency_last_us", 0}, {"apply_latency_max_us", 0}
+};
+
+// payloads are formatted into this buffer, no allocation per message
+JsonWriter<256> json;
+
 //--> Function to publish sensor data based on Mqtt example
-void publishData(mqtt::async_client& client, float hb, float bp, float oxy, float br, float temp) {
-    std::ostringstream payload;
-    payload << "{"
-            << "\"heartbeat\":" << hb << ","
-            << "\"bloodpressure\":" << bp << ","
-            << "\"bloodoxygen\":" << oxy << ","
-            << "\"breathspeed\":" << br << ","
-            << "\"bodytemperature\":" << temp
-            << "}";
-
-    auto msg = mqtt::make_message(TOPIC, payload.str());
-    msg->set_qos(QOS);
+void publishData(Transport& transport, PayloadFormat format, uint64_t seq, int64_t timestampUs, float hb, float bp, float oxy, float br, float temp) {
+    if (format != PayloadFormat::Binary) {
+        std::string_view payload = json.record<VITALS_FIELDS>(seq, timestampUs, hb, bp, oxy, br, temp);
+        transport.publish(TOPIC, std::string(payload), TELEMETRY_QOS);
+    }
 
-    try {
-        client.publish(msg)->wait_for(std::chrono::seconds(10));
-    } catch (const mqtt::exception& exc) {
-        std::cerr << "error publishing: " << exc.what() << std::endl;
+    // packed binary record for bandwidth limited consumers
+    if (format != PayloadFormat::Json) {
+        uint8_t record[TELEMETRY_HEADER_SIZE + 5 * 4];
+        const float values[5] = { hb, bp, oxy, br, temp };
+        size_t size = encodeTelemetry(record, sizeof(record), TelemetryType::Vitals, static_cast<uint32_t>(seq), timestampUs, values, 5);
+        transport.publish(BINARY_TOPIC, std::string(reinterpret_cast<const char*>(record), size), TELEMETRY_QOS);
     }
 }
 
-// This is the function you asked for: receiveData
-void receiveData(const std::string& topic, const std::string& payload) {
-    int value;
+// one frame of every wave from the current vitals, sent with QoS0 because a late frame is of no use to the monitor
+void publishWaveforms(Transport& transport, WaveformGenerator& generator, const VitalSigns& v, bool connected) {
+    static WaveformFrame frames[WAVE_COUNT];
+    static uint8_t payload[WAVEFORM_HEADER_SIZE + 2 * WAVEFORM_MAX_SAMPLES];
 
-    try {
-        value = std::stoi(payload);
-    } catch (...) {
-        std::cerr << "Invalid payload: " << payload << std::endl;
-        return;
-    }
+    // generated while offline too, so the waves continue where they are when the connection is back
+    generator.generate({v.heartBeat, v.breathSpeed}, frames);
+    if (!connected) return;
 
-    if (topic == "change/heartbeat") {
-        vitals.heartBeat.store(value);
+    for (const WaveformFrame& frame : frames) {
+        size_t size = encodeWaveform(payload, sizeof(payload), frame);
+        transport.publish(WAVE_TOPIC + waveName(frame.wave), std::string(reinterpret_cast<const char*>(payload), size), 0);
     }
-    else if (topic == "change/bloodpressure") {
-        vitals.bloodPressure.store(value);
+}
+
+// value names below REMOTE_PREFIX and the field each one sets, same order
+inline constexpr std::string_view COMMAND_TOPICS[] = {
+    "heartbeat", "bloodpressure", "bloodoxygen", "breathspeed", "bodytemperature"
+};
+float VitalSigns::* const COMMAND_TARGETS[] = {
+    &VitalSigns::heartBeat, &VitalSigns::bloodPressure, &VitalSigns::bloodOxygen, &VitalSigns::breathSpeed, &VitalSigns::bodyTemperature
+};
+static_assert(std::size(COMMAND_TOPICS) == std::size(COMMAND_TARGETS), "one field per command topic");
+
+// perfect hash of the command topics, built by the compiler
+using CommandRouter = TopicRouter<COMMAND_TOPICS>;
+
+// one parsed command, passed from the mqtt thread to the main loop
+struct Command {
+    int target;             // index in COMMAND_TOPICS
+    float value;
+    int64_t receivedNs;     // CLOCK_MONOTONIC when it arrived, for the apply latency
+};
+
+// commands waiting for the next tick, the callback never waits for the main loop
+const size_t COMMAND_QUEUE_SIZE = 256;
+const size_t COMMAND_BATCH = 64;                                // max commands applied per tick
+MpscQueue<Command, COMMAND_QUEUE_SIZE> commands;
+
+// counters of the command path, written by the callback (atomic) and the main loop
+struct CommandMetrics {
+    std::atomic<uint64_t> dropped{0};           // queue full
+    std::atomic<uint64_t> unknown{0};           // topic not in COMMAND_TOPICS
+    std::atomic<uint64_t> invalid{0};           // payload is not a number
+    size_t depth = 0;                           // waiting at the start of the last tick
+    size_t maxDepth = 0;
+    uint64_t applied = 0;
+    int64_t lastLatencyUs = 0;                  // arrival to apply of the last command
+    int64_t maxLatencyUs = 0;
+};
+CommandMetrics commandMetrics;
+
+// strip spaces and newlines around a payload
+std::string_view trim(std::string_view text) {
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.front()))) text.remove_prefix(1);
+    while (!text.empty() && std::isspace(static_cast<unsigned char>(text.back()))) text.remove_suffix(1);
+    return text;
+}
+
+// This is the function you asked for: receiveData, runs on the mqtt thread so it only parses and queues
+void receiveData(std::string_view topic, std::string_view payload) {
+    // topic to field with one hash lookup
+    int index = -1;
+    if (topic.substr(0, REMOTE_PREFIX.size()) == REMOTE_PREFIX) index = CommandRouter::find(topic.substr(REMOTE_PREFIX.size()));
+    if (index < 0) {
+        commandMetrics.unknown++;
+        return;
     }
-    else if (topic == "change/bloodoxygen") {
-        vitals.bloodOxygen.store(value);
+
+    // full float, "36.6" stays 36.6
+    float value;
+    payload = trim(payload);
+    auto [end, ec] = std::from_chars(payload.data(), payload.data() + payload.size(), value);
+    if (ec != std::errc() || end != payload.data() + payload.size()) {
+        commandMetrics.invalid++;
+        return;
     }
-    else if (topic == "change/breathspeed") {
-        vitals.breathSpeed.store(value);
+
+    if (!commands.push(Command{index, value, monotonicNs()})) commandMetrics.dropped++;
+}
+
+// apply queued commands at the start of a tick, at most COMMAND_BATCH so a flood cannot stall the loop
+void applyCommands() {
+    commandMetrics.depth = commands.size();
+    if (commandMetrics.depth > commandMetrics.maxDepth) commandMetrics.maxDepth = commandMetrics.depth;
+
+    if (commandMetrics.depth == 0) return;
+
+    // the whole batch is applied before anything is read this tick
+    Command cmd;
+    for (size_t i = 0; i < COMMAND_BATCH && commands.pop(cmd); i++) {
+        vitals.*COMMAND_TARGETS[cmd.target] = cmd.value;
+
+        int64_t latencyUs = (monotonicNs() - cmd.receivedNs) / 1000;
+        commandMetrics.applied++;
+        commandMetrics.lastLatencyUs = latencyUs;
+        if (latencyUs > commandMetrics.maxLatencyUs) commandMetrics.maxLatencyUs = latencyUs;
+
+        std::cout << "[MQTT-VALUE-CHANGED] " << REMOTE_PREFIX << COMMAND_TOPICS[cmd.target] << " Is set to: " << cmd.value << '\n';
     }
-    else if (topic == "change/bodytemperature") {
-        vitals.bodyTemperature.store(value);
+}
+
+// alarm rules, value names are the command names, rates are per minute
+const char* const DEFAULT_ALARM_RULES = R"(
+spo2_low        bloodoxygen      below 90    clear 92    for 10
+hr_high         heartbeat        above 130   clear 120   for 10
+hr_low          heartbeat        below 45    clear 50    for 10
+bp_low          bloodpressure    below 90    clear 95    for 5
+breath_high     breathspeed      above 25    clear 22    for 30
+temp_high       bodytemperature  above 38.5  clear 38.2
+bp_falling      bloodpressure    falling 20  for 10
+)";
+
+// check the rules on one snapshot and send every raise and clear at once, also when no record is due
+void checkAlarms(Transport& transport, AlarmEngine& alarms, std::vector<AlarmEvent>& events, const VitalSigns& v, int64_t timestampUs, bool connected) {
+    float values[std::size(COMMAND_TARGETS)];
+    for (size_t i = 0; i < std::size(COMMAND_TARGETS); i++) values[i] = v.*COMMAND_TARGETS[i];
+
+    size_t count = alarms.evaluate(timestampUs, values, events.data());
+    for (size_t i = 0; i < count; i++) {
+        const AlarmEvent& e = events[i];
+        const std::string& name = alarms.name(e.rule);
+        std::cout << "[ALARM] " << name << (e.active ? " raised" : " cleared") << ", value " << e.value << " limit " << e.limit << std::endl;
+        if (connected) transport.publish(ALARM_TOPIC + name, std::string(json.record<ALARM_FIELDS>(e.active ? 1 : 0, e.value, e.limit, e.timestampUs)), ALARM_QOS);
     }
+}
+
+// scenario values that moved this tick, all set before the tick reads them so a record never mixes two scenario times
+void applyScenario(ScenarioPlayer& player, int64_t scenarioUs) {
+    float values[std::size(COMMAND_TARGETS)];
+    uint32_t moved = player.sample(scenarioUs, values);
+    if (moved == 0) return;
 
-    std::cout << "[MQTT-VALUE-CHANGED] " << topic << " Is set to: " << value << std::endl;
+    for (size_t i = 0; i < std::size(COMMAND_TARGETS); i++) {
+        if (moved & (1u << i)) vitals.*COMMAND_TARGETS[i] = values[i];
+    }
 }
 
+// in-process stand-in for the trainee monitor when running over the loopback, counts what arrives on TOPIC
+struct LoopbackMonitor {
+    std::atomic<uint64_t> records{0};
+    std::atomic<uint64_t> frames{0};
+    std::atomic<uint64_t> alarms{0};
+    std::atomic<uint64_t> other{0};
+    std::atomic<uint64_t> bytes{0};
 
-// MQTT callbacks based on example code
-class callback : public virtual mqtt::callback {
-public:
-    void connected(const std::string& /*cause*/) override {
-        std::cout << "mqtt connected (callback)" << std::endl;
+    void receive(std::string_view topic, std::string_view payload) {
+        bytes += payload.size();
+        if (topic == TOPIC || topic == BINARY_TOPIC) records++;
+        else if (topic.substr(0, WAVE_TOPIC.size()) == WAVE_TOPIC) frames++;
+        else if (topic.substr(0, ALARM_TOPIC.size()) == ALARM_TOPIC) alarms++;
+        else other++;
     }
+};
 
-    void connection_lost(const std::string& cause) override {
-        std::cerr << "mqtt connection lost: " << cause << std::endl;
+int main(int argc, char* argv[]) {
+    // payload format from the command line
+    PayloadFormat format = PayloadFormat::Json;
+    bool waveforms = false;
+    const char* scenarioPath = nullptr;
+    const char* rulesPath = nullptr;
+    double warp = 1.0;
+    bool loopback = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) format = parsePayloadFormat(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--waveforms") == 0) waveforms = true;
+        else if (std::strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) scenarioPath = argv[++i];
+        else if (std::strcmp(argv[i], "--warp") == 0 && i + 1 < argc) warp = std::strtod(argv[++i], nullptr);
+        else if (std::strcmp(argv[i], "--rules") == 0 && i + 1 < argc) rulesPath = argv[++i];
+        else if (std::strcmp(argv[i], "--loopback") == 0) loopback = true;
     }
 
-    void message_arrived(mqtt::const_message_ptr msg) override {
-        if (!msg) return;
+    // alarm rules are compiled once, a bad rule stops the program before it connects
+    std::unique_ptr<AlarmEngine> alarms;
+    try {
+        alarms = std::make_unique<AlarmEngine>(rulesPath ? readAlarmRules(rulesPath) : DEFAULT_ALARM_RULES, COMMAND_TOPICS, std::size(COMMAND_TOPICS));
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    std::vector<AlarmEvent> alarmEvents(alarms->size());
 
-        // Only handle remote control topic
-        receiveData(msg->get_topic(), msg->to_string());
+    // scenario is read and checked before connecting, value names are the command names
+    std::unique_ptr<Scenario> scenario;
+    std::unique_ptr<ScenarioPlayer> player;
+    if (scenarioPath) {
+        try {
+            scenario = std::make_unique<Scenario>(scenarioPath, COMMAND_TOPICS, std::size(COMMAND_TOPICS));
+        } catch (const std::runtime_error& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        player = std::make_unique<ScenarioPlayer>(*scenario);
+        std::cout << "scenario " << scenarioPath << ", " << scenario->durationUs() / 1000000 << " s at " << warp << "x" << std::endl;
     }
 
-    void delivery_complete(mqtt::delivery_token_ptr /*tok*/) override {}
-};
+    // wall time per tick, warp 0 means no waiting at all
+    const auto tickPeriod = warp > 0.0 ? std::chrono::duration_cast<std::chrono::steady_clock::duration>(TICK / warp)
+                                       : std::chrono::steady_clock::duration::zero();
 
-int main() {
     // --> SETUP
-    mqtt::async_client client(SERVER_ADDRESS, CLIENT_ID);
-    mqtt::connect_options connOpts;
-    connOpts.set_clean_session(true);
-    connOpts.set_user_name(MQTT_USERNAME);
-    connOpts.set_password(MQTT_PASSWORD);
+    // the broker, or with --loopback an in-process queue with a stand-in monitor so no network is needed
+    std::unique_ptr<mqtt::async_client> client;
+    std::unique_ptr<Transport> transport;
+    PahoTransport* paho = nullptr;
+    LoopbackMonitor monitor;
+    if (loopback) {
+        auto queue = std::make_unique<LoopbackTransport>();
+        queue->attach(TOPIC + "/#", [&monitor](std::string_view topic, std::string_view payload) { monitor.receive(topic, payload); });
+        transport = std::move(queue);
+    } else {
+        client = std::make_unique<mqtt::async_client>(SERVER_ADDRESS, CLIENT_ID);
+        mqtt::connect_options connOpts;
+        connOpts.set_user_name(MQTT_USERNAME);
+        connOpts.set_password(MQTT_PASSWORD);
 
-    // Set callback
-    callback cb;
-    client.set_callback(cb);
+        // Connection manager inside the transport owns the paho callback and keeps the connection up.
+        // publishing never waits for an ack, only --warp 0 waits for a free slot so it goes as fast as the broker takes it
+        BackpressurePolicy policy = warp > 0.0 ? BackpressurePolicy::DropNewest : BackpressurePolicy::Block;
+        auto broker = std::make_unique<PahoTransport>(*client, connOpts, ReconnectOptions{}, MAX_IN_FLIGHT, policy);
+        paho = broker.get();
+        transport = std::move(broker);
+    }
 
-    try {
-        client.connect(connOpts)->wait();
-        std::cout << "mqtt ok" << std::endl;
+    // Subscribe to remote control topic, again after every reconnect, commands go to receiveData
+    transport->subscribe(REMOTE_TOPIC, QOS);
+    transport->setMessageHandler(receiveData);
+    transport->start();
 
-        // Subscribe to remote control topic
-        client.subscribe(REMOTE_TOPIC, QOS)->wait();
-        std::cout << "subscribed to " << REMOTE_TOPIC << std::endl;
+    // sequence number of the published records
+    uint64_t seq = 0;
 
-    } catch (const mqtt::exception& exc) {
-        std::cerr << "mqtt failed: " << exc.what() << std::endl;
-        return 1;
-    }
+    // waveform engine, first sample at the start of the loop
+    int64_t originUs = wallMicros(monotonicNs());
+    WaveformOptions waveOptions;
+    waveOptions.framePeriod = TICK;
+    WaveformGenerator waves(originUs, waveOptions);
+    int tick = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto nextTick = start;
 
     // --> MAIN LOOP
     while (true) {
-        // read sensor data 
-        float hb   = vitals.heartBeat;
-        float bp   = vitals.bloodPressure;
-        float oxy  = vitals.bloodOxygen;
-        float br   = vitals.breathSpeed;
-        float temp = vitals.bodyTemperature;
-
-        // display data
-        std::cout << "Temperature: " << temp << " °C" << std::endl;
-        std::cout << "Heart Beat: " << hb << " bpm" << std::endl;
-        std::cout << "Blood Pressure: " << bp << " mmHg" << std::endl;
-        std::cout << "Blood Oxygen: " << oxy << " %" << std::endl;
-        std::cout << "Breath Speed: " << br << " breaths/min" << std::endl;
-        std::cout << "-----------------------------" << std::endl;
-        
-        // publish data
-        publishData(client, hb, bp, oxy, br, temp);
-        
-        // wait before next read
-        std::this_thread::sleep_for(std::chrono::seconds(5) );
+        // scenario time of this tick, the same at every warp
+        int64_t scenarioUs = tick * std::chrono::duration_cast<std::chrono::microseconds>(TICK).count();
+        if (player) {
+            if (player->finished(scenarioUs)) break;
+            applyScenario(*player, scenarioUs);
+            while (const Scenario::Event* event = player->nextEvent(scenarioUs)) {
+                std::cout << "[SCENARIO-EVENT] " << event->timeUs / 1000000 << " s: " << event->text << std::endl;
+                if (transport->state() == ConnectionState::Connected) transport->publish(EVENT_TOPIC, event->text, QOS);
+            }
+        }
+
+        // commands that arrived since the last tick
+        applyCommands();
+
+        // one snapshot for everything sent this tick
+        const VitalSigns& snapshot = vitals;
+        bool connected = transport->state() == ConnectionState::Connected;
+
+        // alarms every tick, in scenario time when a scenario plays
+        int64_t nowUs = player ? originUs + scenarioUs : wallMicros(monotonicNs());
+        checkAlarms(*transport, *alarms, alarmEvents, snapshot, nowUs, connected);
+
+        // waveform frames every tick
+        if (waveforms) publishWaveforms(*transport, waves, snapshot, connected);
+
+        if (tick++ % VITALS_EVERY == 0) {
+            // read sensor data, all five from the same snapshot
+            float hb   = snapshot.heartBeat;
+            float bp   = snapshot.bloodPressure;
+            float oxy  = snapshot.bloodOxygen;
+            float br   = snapshot.breathSpeed;
+            float temp = snapshot.bodyTemperature;
+
+            // stamp the moment the values were read, in scenario time when a scenario plays
+            int64_t timestampUs = nowUs;
+            seq++;
+
+            // display data
+            std::cout << "Record: " << seq << " @ " << timestampUs << " us" << std::endl;
+            std::cout << "Temperature: " << temp << " °C" << std::endl;
+            std::cout << "Heart Beat: " << hb << " bpm" << std::endl;
+            std::cout << "Blood Pressure: " << bp << " mmHg" << std::endl;
+            std::cout << "Blood Oxygen: " << oxy << " %" << std::endl;
+            std::cout << "Breath Speed: " << br << " breaths/min" << std::endl;
+
+            // command queue metrics
+            std::string metrics(json.record<COMMAND_METRICS_FIELDS>(commandMetrics.depth, commandMetrics.maxDepth, commandMetrics.applied,
+                                                                   commandMetrics.dropped.load(), commandMetrics.unknown.load(), commandMetrics.invalid.load(),
+                                                                   commandMetrics.lastLatencyUs, commandMetrics.maxLatencyUs));
+            std::cout << "Commands: " << metrics << std::endl;
+            std::cout << "-----------------------------" << std::endl;
+
+            // publish data, while offline the record is skipped so the loop keeps its pace
+            if (connected) {
+                publishData(*transport, format, seq, timestampUs, hb, bp, oxy, br, temp);
+                transport->publish(METRICS_TOPIC, std::move(metrics), 0);
+            } else if (paho) {
+                ConnectionMetrics m = paho->metrics();
+                std::cout << "mqtt " << connectionStateName(m.state) << ", " << m.reconnects << " reconnects, "
+                          << m.failedAttempts << " failed attempts, record not sent" << std::endl;
+            }
+        }
+
+        // wait for the next tick, fixed deadlines so the frames do not drift
+        nextTick += player ? tickPeriod : TICK;
+        std::this_thread::sleep_until(nextTick);
     }
 
-    // Unreachable, but kept for completeness
-    client.disconnect()->wait();
+    // only reached at the end of a scenario
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "scenario done: " << tick << " ticks, " << seq << " records in " << elapsed.count() << " s ("
+              << (tick * std::chrono::duration<double>(TICK).count()) / elapsed.count() << "x real time)" << std::endl;
+    transport->stop();
+    if (loopback) {
+        std::cout << "loopback monitor: " << monitor.records << " records, " << monitor.frames << " waveform frames, " << monitor.alarms
+                  << " alarms, " << monitor.other << " other, " << monitor.bytes << " bytes, "
+                  << static_cast<LoopbackTransport&>(*transport).metrics().dropped << " dropped" << std::endl;
+    }
     return 0;
 }
@@ -0,0 +1,148 @@
+/*!
+ * \file      scenario.cpp
+ * \brief     Scenario timeline of vitals keyframes and events, played back with time warp
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "scenario.hpp"
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+//--> Keyframe of one value
+struct Keyframe {
+    int64_t timeUs;
+    float value;
+};
+
+//--> Next word of a line, leading spaces skipped
+static std::string_view nextWord(std::string_view& line) {
+    while (!line.empty() && std::isspace(static_cast<unsigned char>(line.front()))) line.remove_prefix(1);
+    size_t end = 0;
+    while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end]))) end++;
+    std::string_view word = line.substr(0, end);
+    line.remove_prefix(end);
+    return word;
+}
+
+//--> Whole word as a number
+static bool parseNumber(std::string_view text, double& value) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size();
+}
+
+//--> seconds, m:ss or h:mm:ss to us
+static bool parseTime(std::string_view text, int64_t& timeUs) {
+    double total = 0.0;
+    int parts = 0;
+    while (true) {
+        size_t colon = text.find(':');
+        double part;
+        if (!parseNumber(text.substr(0, colon), part) || part < 0.0) return false;
+        total = total * 60.0 + part;
+        if (++parts > 3) return false;
+        if (colon == std::string_view::npos) break;
+        text.remove_prefix(colon + 1);
+    }
+    timeUs = static_cast<int64_t>(total * 1e6 + 0.5);
+    return true;
+}
+
+//--> Constructor, parse all lines then turn the keyframes into segments
+Scenario::Scenario(const std::string& path, const std::string_view* names, size_t fieldCount) : fields(fieldCount) {
+    if (fields > SCENARIO_MAX_FIELDS) throw std::runtime_error("scenario: too many value names");
+
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("cannot open scenario: " + path);
+
+    std::vector<Keyframe> keyframes[SCENARIO_MAX_FIELDS];
+    int64_t lastTimeUs = 0;
+    std::string text;
+    for (int lineNumber = 1; std::getline(file, text); lineNumber++) {
+        std::string where = path + ":" + std::to_string(lineNumber) + ": ";
+        std::string_view line = text;
+        line = line.substr(0, line.find('#'));
+
+        std::string_view word = nextWord(line);
+        if (word.empty()) continue;
+
+        int64_t timeUs;
+        if (!parseTime(word, timeUs)) throw std::runtime_error(where + "bad time '" + std::string(word) + "'");
+        if (timeUs < lastTimeUs) throw std::runtime_error(where + "time goes back");
+        lastTimeUs = timeUs;
+
+        word = nextWord(line);
+        if (word == "event") {
+            while (!line.empty() && std::isspace(static_cast<unsigned char>(line.front()))) line.remove_prefix(1);
+            while (!line.empty() && std::isspace(static_cast<unsigned char>(line.back()))) line.remove_suffix(1);
+            eventList.push_back(Event{timeUs, std::string(line)});
+            continue;
+        }
+        if (word.empty()) throw std::runtime_error(where + "no values");
+
+        //--> name value pairs
+        for (; !word.empty(); word = nextWord(line)) {
+            size_t field = 0;
+            while (field < fields && names[field] != word) field++;
+            if (field == fields) throw std::runtime_error(where + "unknown value '" + std::string(word) + "'");
+
+            std::string_view number = nextWord(line);
+            double value;
+            if (!parseNumber(number, value)) throw std::runtime_error(where + "bad number for " + std::string(word));
+            keyframes[field].push_back(Keyframe{timeUs, static_cast<float>(value)});
+        }
+    }
+    duration = lastTimeUs;
+
+    //--> One segment per pair of keyframes, the last keyframe holds forever
+    for (size_t f = 0; f < fields; f++) {
+        const std::vector<Keyframe>& k = keyframes[f];
+        for (size_t i = 0; i < k.size(); i++) {
+            Segment segment{k[i].timeUs, std::numeric_limits<int64_t>::max(), k[i].value, 0.0};
+            if (i + 1 < k.size()) {
+                segment.endUs = k[i + 1].timeUs;
+                if (segment.endUs > segment.startUs) segment.slope = (k[i + 1].value - k[i].value) / static_cast<double>(segment.endUs - segment.startUs);
+            }
+            //--> A jump leaves an empty segment, playback never stops in it
+            if (segment.endUs > segment.startUs) fieldSegments[f].push_back(segment);
+        }
+    }
+}
+
+//--> Constructor
+ScenarioPlayer::ScenarioPlayer(const Scenario& s) : scenario(s) {}
+
+//--> Walk each cursor forward to the segment holding timeUs
+uint32_t ScenarioPlayer::sample(int64_t timeUs, float* values) {
+    uint32_t mask = 0;
+    for (size_t f = 0; f < scenario.fieldCount(); f++) {
+        const std::vector<Scenario::Segment>& segments = scenario.segments(f);
+        if (segments.empty() || timeUs < segments.front().startUs) continue;
+
+        size_t& i = cursor[f];
+        while (timeUs >= segments[i].endUs) i++;
+        const Scenario::Segment& s = segments[i];
+        float value = static_cast<float>(s.start + s.slope * static_cast<double>(timeUs - s.startUs));
+
+        //--> Only what moved, so a command on a value that is holding stays until the scenario moves it again
+        if (!started[f] || value != written[f]) {
+            values[f] = value;
+            written[f] = value;
+            started[f] = true;
+            mask |= 1u << f;
+        }
+    }
+    return mask;
+}
+
+//--> Events in file order
+const Scenario::Event* ScenarioPlayer::nextEvent(int64_t timeUs) {
+    const std::vector<Scenario::Event>& events = scenario.events();
+    if (eventCursor == events.size() || events[eventCursor].timeUs > timeUs) return nullptr;
+    return &events[eventCursor++];
+}
@@ -0,0 +1,112 @@
+/*!
+ * \file      scenario.hpp
+ * \brief     Scenario timeline of vitals keyframes and events, played back with time warp
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * A scenario is a text file, one entry per line, in time order:
+ *
+ *   # comment
+ *   0:00    heartbeat 72  breathspeed 16  bodytemperature 36.8
+ *   10:00   heartbeat 110 bodytemperature 38.5
+ *   10:00   event blood cultures taken
+ *   12:00   bloodpressure 120
+ *   12:30   bloodpressure 85
+ *
+ * A time is seconds, m:ss or h:mm:ss (seconds may have decimals). A line
+ * with value names is a keyframe: the value is reached at that time and
+ * runs in a straight line from the previous keyframe of the same value, so
+ * bloodpressure above drops from 120 to 85 in 30 s. Two keyframes at the
+ * same time make a jump. A value is driven from its first keyframe on and
+ * holds its last keyframe after the end. Values that never appear in the
+ * scenario are left alone. An "event" line carries a text that is handed out
+ * once when playback passes its time.
+ *
+ * The file is read once; every pair of keyframes becomes a segment with a
+ * start value and a slope, so playback is one multiply-add per value and a
+ * cursor that only moves forward.
+ *
+ */
+
+#ifndef SCENARIO_HPP
+#define SCENARIO_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//--> Max values a scenario can drive
+const size_t SCENARIO_MAX_FIELDS = 16;
+
+//--> Timeline loaded from a file, read only after loading
+class Scenario {
+
+//-> Public functions
+public:
+    //--> One straight piece of a value: value(t) = start + slope * (t - startUs), until endUs
+    struct Segment {
+        int64_t startUs;
+        int64_t endUs;              // INT64_MAX for the hold after the last keyframe
+        double start;
+        double slope;               // per us
+    };
+
+    //--> Text event
+    struct Event {
+        int64_t timeUs;
+        std::string text;
+    };
+
+    //--> Constructor, reads and checks the file, field names are the value names allowed in it (throws std::runtime_error)
+    Scenario(const std::string& path, const std::string_view* fields, size_t fieldCount);
+
+    //--> Time of the last keyframe or event
+    int64_t durationUs() const { return duration; }
+
+    //--> Segments of one value, empty when the scenario does not drive it
+    const std::vector<Segment>& segments(size_t field) const { return fieldSegments[field]; }
+
+    //--> All events in time order
+    const std::vector<Event>& events() const { return eventList; }
+
+    //--> Number of value names
+    size_t fieldCount() const { return fields; }
+
+//-> Private functions and variables
+private:
+    size_t fields;
+    int64_t duration = 0;
+    std::vector<Segment> fieldSegments[SCENARIO_MAX_FIELDS];
+    std::vector<Event> eventList;
+};
+
+//--> Playback position in a scenario, one per patient
+class ScenarioPlayer {
+
+//-> Public functions
+public:
+    //--> Constructor, starts at time 0
+    explicit ScenarioPlayer(const Scenario& scenario);
+
+    //--> Values at timeUs (not before the last call), only values that moved since the last call are written, returns a bit per written value
+    uint32_t sample(int64_t timeUs, float* values);
+
+    //--> Next event at or before timeUs that was not handed out yet, nullptr when there is none
+    const Scenario::Event* nextEvent(int64_t timeUs);
+
+    //--> True when timeUs is past the last keyframe and event
+    bool finished(int64_t timeUs) const { return timeUs > scenario.durationUs(); }
+
+//-> Private functions and variables
+private:
+    const Scenario& scenario;
+    size_t cursor[SCENARIO_MAX_FIELDS] = {};        // current segment per value
+    float written[SCENARIO_MAX_FIELDS];             // last value handed out
+    bool started[SCENARIO_MAX_FIELDS] = {};
+    size_t eventCursor = 0;
+};
+
+#endif //--> SCENARIO_HPP
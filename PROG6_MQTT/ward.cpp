@@ -0,0 +1,145 @@
+/*!
+ * \file      ward.cpp
+ * \brief     Many simulated patients in one process
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "ward.hpp"
+#include "clock.hpp"
+#include "topic_router.hpp"
+#include <cctype>
+#include <charconv>
+#include <cstdio>
+
+//--> Topic layout
+static const std::string_view WARD_PREFIX{"ward/bed-"};
+static const std::string_view CHANGE_PREFIX{"/change/"};
+const std::string Ward::COMMAND_FILTER{"ward/+/change/#"};
+
+//--> Command names, same order as VitalField
+inline constexpr std::string_view FIELD_TOPICS[] = {
+    "heartbeat", "bloodpressure", "bloodoxygen", "breathspeed", "bodytemperature"
+};
+static_assert(std::size(FIELD_TOPICS) == VITAL_COUNT, "one command per vital field");
+using FieldRouter = TopicRouter<FIELD_TOPICS>;
+
+//--> Start values of a new patient
+static const float DEFAULT_VALUES[VITAL_COUNT] = { 72.0f, 120.0f, 98.0f, 16.0f, 36.8f };
+
+//--> Same record as the single patient monitor
+inline constexpr JsonField WARD_VITALS_FIELDS[] = {
+    {"seq", 0}, {"ts_us", 0}, {"heartbeat", 1}, {"bloodpressure", 1}, {"bloodoxygen", 1}, {"breathspeed", 1}, {"bodytemperature", 1}
+};
+
+//--> Constructor, every patient starts with the defaults and its own topics
+Ward::Ward(const WardOptions& opts, int64_t originUs) : options(opts) {
+    for (size_t f = 0; f < VITAL_COUNT; f++) values[f].assign(options.patients, DEFAULT_VALUES[f]);
+    sequence.assign(options.patients, 0);
+
+    WaveformOptions waveOptions;
+    waveOptions.framePeriod = options.tick;
+    waves.reserve(options.patients);
+    topics.resize(options.patients);
+
+    for (size_t i = 0; i < options.patients; i++) {
+        waves.emplace_back(originUs, waveOptions);
+
+        char bed[32];
+        std::snprintf(bed, sizeof(bed), "%.*s%03zu/", static_cast<int>(WARD_PREFIX.size()), WARD_PREFIX.data(), i + 1);
+        topics[i].current = std::string(bed) + "current";
+        topics[i].binary = topics[i].current + TELEMETRY_BINARY_SUFFIX;
+        for (size_t w = 0; w < WAVE_COUNT; w++) topics[i].wave[w] = topics[i].current + "/wave/" + waveName(static_cast<Wave>(w));
+    }
+}
+
+//--> ward/bed-NNN/change/<name>, bed and name are both looked up without building strings
+void Ward::receive(std::string_view topic, std::string_view payload) {
+    if (topic.substr(0, WARD_PREFIX.size()) != WARD_PREFIX) {
+        unknown++;
+        return;
+    }
+    topic.remove_prefix(WARD_PREFIX.size());
+
+    uint32_t bed = 0;
+    auto [rest, ec] = std::from_chars(topic.data(), topic.data() + topic.size(), bed);
+    topic.remove_prefix(rest - topic.data());
+    int field = -1;
+    if (ec == std::errc() && topic.substr(0, CHANGE_PREFIX.size()) == CHANGE_PREFIX) {
+        field = FieldRouter::find(topic.substr(CHANGE_PREFIX.size()));
+    }
+    if (field < 0 || bed < 1 || bed > options.patients) {
+        unknown++;
+        return;
+    }
+
+    //--> Plain number, spaces around it are allowed
+    while (!payload.empty() && std::isspace(static_cast<unsigned char>(payload.front()))) payload.remove_prefix(1);
+    while (!payload.empty() && std::isspace(static_cast<unsigned char>(payload.back()))) payload.remove_suffix(1);
+    float value;
+    auto [end, err] = std::from_chars(payload.data(), payload.data() + payload.size(), value);
+    if (err != std::errc() || end != payload.data() + payload.size()) {
+        invalid++;
+        return;
+    }
+
+    if (!commands.push(Command{bed - 1, static_cast<uint8_t>(field), value, monotonicNs()})) dropped++;
+}
+
+//--> One scheduler step for the whole ward
+void Ward::tick(const Send& send) {
+    int64_t start = monotonicNs();
+
+    //--> Commands first, so this tick already sends the new values
+    Command cmd;
+    while (commands.pop(cmd)) {
+        values[cmd.field][cmd.patient] = cmd.value;
+        applied++;
+    }
+
+    //--> Waveforms of every patient, vitals of the patients whose turn it is
+    size_t slot = tickCount % options.vitalsEvery;
+    for (size_t i = 0; i < options.patients; i++) {
+        if (options.waveforms) sendWaves(i, send);
+        if (i % options.vitalsEvery == slot) sendVitals(i, send);
+    }
+
+    tickCount++;
+    lastTickUs = (monotonicNs() - start) / 1000;
+    if (lastTickUs > maxTickUs) maxTickUs = lastTickUs;
+}
+
+//--> JSON and/or binary record of one patient
+void Ward::sendVitals(size_t i, const Send& send) {
+    float v[VITAL_COUNT];
+    for (size_t f = 0; f < VITAL_COUNT; f++) v[f] = values[f][i];
+    uint64_t seq = ++sequence[i];
+    int64_t timestampUs = wallMicros(monotonicNs());
+
+    if (options.format != PayloadFormat::Binary) {
+        send(topics[i].current, json.record<WARD_VITALS_FIELDS>(seq, timestampUs, v[0], v[1], v[2], v[3], v[4]), 1);
+        messages++;
+    }
+    if (options.format != PayloadFormat::Json) {
+        uint8_t record[TELEMETRY_HEADER_SIZE + VITAL_COUNT * 4];
+        size_t size = encodeTelemetry(record, sizeof(record), TelemetryType::Vitals, static_cast<uint32_t>(seq), timestampUs, v, VITAL_COUNT);
+        send(topics[i].binary, std::string_view(reinterpret_cast<const char*>(record), size), 1);
+        messages++;
+    }
+}
+
+//--> Next frame of every wave of one patient, QoS0 like the single monitor
+void Ward::sendWaves(size_t i, const Send& send) {
+    waves[i].generate({values[HEART_BEAT][i], values[BREATH_SPEED][i]}, frames);
+    for (const WaveformFrame& frame : frames) {
+        size_t size = encodeWaveform(wavePayload, sizeof(wavePayload), frame);
+        send(topics[i].wave[static_cast<size_t>(frame.wave)], std::string_view(reinterpret_cast<const char*>(wavePayload), size), 0);
+        messages++;
+    }
+}
+
+//--> Copy of the counters
+WardMetrics Ward::metrics() const {
+    return WardMetrics{tickCount, messages, applied, dropped.load(), unknown.load(), invalid.load(), lastTickUs, maxTickUs};
+}
@@ -0,0 +1,148 @@
+/*!
+ * \file      ward.hpp
+ * \brief     Many simulated patients in one process
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * A ward holds N independent patients. The state is stored per field
+ * (structure of arrays): all heart rates next to each other, all blood
+ * pressures next to each other, and so on, plus one waveform generator per
+ * patient in one array. One tick() walks all patients in order, so the whole
+ * ward is driven by a single scheduler and shares one mqtt connection.
+ *
+ * Every patient has its own topic namespace below "ward/bed-NNN/" (bed
+ * numbers start at 1):
+ *
+ *   ward/bed-007/current            vitals record (JSON), as the single monitor
+ *   ward/bed-007/current/bin        same as binary record (--format binary|both)
+ *   ward/bed-007/current/wave/ecg   waveform frames (pleth, resp likewise)
+ *   ward/bed-007/change/heartbeat   command topics, subscribe to ward/+/change/#
+ *
+ * Vitals records are spread over the ticks of the vitals period (bed 1 in
+ * tick 0, bed 2 in tick 1, ...) so the ward does not send 200 records in
+ * the same tick.
+ *
+ */
+
+#ifndef WARD_HPP
+#define WARD_HPP
+
+#include "json_writer.hpp"
+#include "mpsc_queue.hpp"
+#include "telemetry_codec.hpp"
+#include "waveform.hpp"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//--> Vital fields, index into the state arrays and order of the records
+enum VitalField {
+    HEART_BEAT,
+    BLOOD_PRESSURE,
+    BLOOD_OXYGEN,
+    BREATH_SPEED,
+    BODY_TEMPERATURE,
+    VITAL_COUNT
+};
+
+//--> Ward setup
+struct WardOptions {
+    size_t patients = 200;
+    PayloadFormat format = PayloadFormat::Json;
+    bool waveforms = false;
+    std::chrono::milliseconds tick{200};        // also the waveform frame period
+    int vitalsEvery = 25;                       // ticks between vitals records of one patient
+};
+
+//--> Ward counters
+struct WardMetrics {
+    uint64_t ticks;
+    uint64_t messages;              // handed to the send function
+    uint64_t applied;               // commands applied
+    uint64_t dropped;               // command queue full
+    uint64_t unknown;               // topic is not a bed or command we know
+    uint64_t invalid;               // payload is not a number
+    int64_t lastTickUs;             // time spent in the last tick
+    int64_t maxTickUs;
+};
+
+//--> N patients driven by one scheduler
+class Ward {
+
+//-> Public functions
+public:
+    //--> Publishes one payload, called from tick()
+    using Send = std::function<void(const std::string& topic, std::string_view payload, int qos)>;
+
+    //--> Constructor, originUs is the unix time of the first waveform sample
+    Ward(const WardOptions& options, int64_t originUs);
+
+    //--> Parse a command and queue it, safe from the mqtt thread, never blocks
+    void receive(std::string_view topic, std::string_view payload);
+
+    //--> Apply queued commands and send everything that is due this tick
+    void tick(const Send& send);
+
+    //--> Subscription for the command topics of all beds
+    static const std::string COMMAND_FILTER;
+
+    //--> Current counters
+    WardMetrics metrics() const;
+
+    //--> Value of one field of one patient (0 based)
+    float value(size_t patient, VitalField field) const { return values[field][patient]; }
+
+    //--> Number of patients
+    size_t size() const { return options.patients; }
+
+//-> Private functions and variables
+private:
+    //--> Command handed from the mqtt thread to tick()
+    struct Command {
+        uint32_t patient;
+        uint8_t field;
+        float value;
+        int64_t receivedNs;
+    };
+
+    //--> Topics of one patient, built once
+    struct Topics {
+        std::string current;
+        std::string binary;
+        std::string wave[WAVE_COUNT];
+    };
+
+    WardOptions options;
+    std::array<std::vector<float>, VITAL_COUNT> values;     // structure of arrays
+    std::vector<uint64_t> sequence;
+    std::vector<WaveformGenerator> waves;
+    std::vector<Topics> topics;
+
+    MpscQueue<Command, 4096> commands;
+    JsonWriter<256> json;
+    WaveformFrame frames[WAVE_COUNT];
+    uint8_t wavePayload[WAVEFORM_HEADER_SIZE + 2 * WAVEFORM_MAX_SAMPLES];
+    uint64_t tickCount = 0;
+
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> unknown{0};
+    std::atomic<uint64_t> invalid{0};
+    uint64_t messages = 0;
+    uint64_t applied = 0;
+    int64_t lastTickUs = 0;
+    int64_t maxTickUs = 0;
+
+    //--> Send the vitals record of one patient
+    void sendVitals(size_t patient, const Send& send);
+
+    //--> Send one waveform frame set of one patient
+    void sendWaves(size_t patient, const Send& send);
+};
+
+#endif //--> WARD_HPP
@@ -0,0 +1,122 @@
+/*!
+ * \file      ward_main.cpp
+ * \brief     Main entry point for a ward of simulated patient monitors on one MQTT connection
+ * \author    Wietse Houwers
+ * \date      October 2026
+ */
+
+
+/*
+* one process for a whole ward instead of one ./mqtt process per bed.
+*
+* every bed behaves like the single monitor in main.cpp, but below its own topic namespace ward/bed-NNN/ (see ward.hpp).
+* all beds share one transport (common/transport.hpp) and one loop that runs every 200 ms, commands arrive on ward/+/change/#.
+* with the broker that is one mqtt connection (common/paho_transport, kept up by common/connection_manager), publishing never waits for the broker ack.
+* with --loopback nothing goes over the network: the messages go through an in-process queue (common/loopback_transport.hpp) to a stand-in monitor that counts them.
+*
+* command used to compile:  g++ -O2 ward_main.cpp ward.cpp waveform.cpp ../common/telemetry_codec.cpp ../common/connection_manager.cpp ../common/paho_transport.cpp ../common/loopback_transport.cpp ../common/inflight_publisher.cpp ../common/spool.cpp ../common/topic_aliases.cpp -I../common -o mqtt_ward -lpaho-mqttpp3 -lpaho-mqtt3as -pthread
+* then to run: ./mqtt_ward [--patients 200] [--format json|binary|both] [--waveforms] [--loopback]
+* bench_ward.cpp measures how many beds one core can simulate.
+*/
+
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <memory>
+#include <mqtt/async_client.h>
+#include "clock.hpp"
+#include "paho_transport.hpp"
+#include "loopback_transport.hpp"
+#include "ward.hpp"
+
+//--> mqtt setup
+const std::string SERVER_ADDRESS{"tcp://192.168.50.95:1883"};   // change to "tcp://127.0.0.1:1883" when using local broker
+const std::string CLIENT_ID{"WIETSE-WARD"};                     // one client for all beds
+const int QOS = 1;
+
+//--> mqtt authentication
+const std::string MQTT_USERNAME{"school"};
+const std::string MQTT_PASSWORD{"Han@2025!"};
+
+//--> publish window, at 200 beds with waveforms the ward sends about 3000 messages per second
+const size_t MAX_IN_FLIGHT = 1024;
+const int STATUS_EVERY = 25;                                    // ticks between status lines
+
+
+int main(int argc, char* argv[]) {
+    // options from the command line
+    WardOptions options;
+    bool loopback = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--patients") == 0 && i + 1 < argc) options.patients = std::strtoul(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) options.format = parsePayloadFormat(argv[++i]);
+        else if (std::strcmp(argv[i], "--waveforms") == 0) options.waveforms = true;
+        else if (std::strcmp(argv[i], "--loopback") == 0) loopback = true;
+    }
+
+    // --> SETUP
+    Ward ward(options, wallMicros(monotonicNs()));
+
+    // the broker, or with --loopback an in-process queue with a stand-in monitor that counts what it gets
+    std::unique_ptr<mqtt::async_client> client;
+    std::unique_ptr<Transport> transport;
+    PahoTransport* paho = nullptr;
+    std::atomic<uint64_t> received{0};
+    if (loopback) {
+        auto queue = std::make_unique<LoopbackTransport>();
+        queue->attach("ward/+/current/#", [&received](std::string_view, std::string_view) { received++; });
+        transport = std::move(queue);
+    } else {
+        client = std::make_unique<mqtt::async_client>(SERVER_ADDRESS, CLIENT_ID);
+        mqtt::connect_options connOpts;
+        connOpts.set_user_name(MQTT_USERNAME);
+        connOpts.set_password(MQTT_PASSWORD);
+
+        // shared publisher inside the transport, drops new messages when the broker falls behind
+        auto broker = std::make_unique<PahoTransport>(*client, connOpts, ReconnectOptions{}, MAX_IN_FLIGHT, BackpressurePolicy::DropNewest);
+        paho = broker.get();
+        transport = std::move(broker);
+    }
+
+    // commands go straight into the ward queue
+    transport->subscribe(Ward::COMMAND_FILTER, QOS);
+    transport->setMessageHandler([&ward](std::string_view topic, std::string_view payload) { ward.receive(topic, payload); });
+    transport->start();
+
+    Ward::Send send = [&](const std::string& topic, std::string_view payload, int qos) {
+        if (transport->state() != ConnectionState::Connected) return;
+        transport->publish(topic, std::string(payload), qos);
+    };
+
+    std::cout << "ward with " << ward.size() << " beds" << (options.waveforms ? " and waveforms" : "") << std::endl;
+
+    // --> MAIN LOOP
+    auto nextTick = std::chrono::steady_clock::now();
+    for (uint64_t tick = 1; ; tick++) {
+        ward.tick(send);
+
+        if (tick % STATUS_EVERY == 0) {
+            WardMetrics w = ward.metrics();
+            std::cout << "ticks " << w.ticks << ", messages " << w.messages << ", tick " << w.lastTickUs << " us (max " << w.maxTickUs << " us)"
+                      << ", commands " << w.applied << " applied " << w.dropped << " dropped " << w.unknown << " unknown " << w.invalid << " invalid";
+            if (paho) {
+                PublisherMetrics p = paho->publisherMetrics();
+                std::cout << ", in flight " << p.inFlight << ", publish dropped " << p.dropped;
+            } else {
+                std::cout << ", monitor received " << received.load();
+            }
+            std::cout << ", mqtt " << connectionStateName(transport->state()) << std::endl;
+        }
+
+        // fixed deadlines, a slow tick is caught up instead of shifting every later one
+        nextTick += options.tick;
+        std::this_thread::sleep_until(nextTick);
+    }
+
+    // Unreachable, but kept for completeness
+    transport->stop();
+    return 0;
+}
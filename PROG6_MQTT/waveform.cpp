@@ -0,0 +1,207 @@
+/*!
+ * \file      waveform.cpp
+ * \brief     ECG, pleth and respiration waveforms driven by the current vitals
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "waveform.hpp"
+#include "telemetry_codec.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+
+//--> Points per template cycle
+const size_t TABLE_SIZE = 512;
+using WaveTable = std::array<float, TABLE_SIZE + 1>;    // one extra point for interpolation at the end
+
+//--> Fixed point scale per wave
+const float ECG_SCALE = 1000.0f;        // mV to uV
+const float UNIT_SCALE = 10000.0f;      // 0..1 to 1/10000
+
+//--> Gaussian bump at center with width, phase in cycles
+static double bump(double x, double center, double width) {
+    double d = (x - center) / width;
+    return std::exp(-0.5 * d * d);
+}
+
+//--> One beat of lead II in mV: P, Q, R, S and T wave
+static WaveTable buildEcg() {
+    WaveTable t;
+    for (size_t i = 0; i <= TABLE_SIZE; i++) {
+        double x = static_cast<double>(i) / TABLE_SIZE;
+        t[i] = static_cast<float>(0.15 * bump(x, 0.20, 0.025) - 0.12 * bump(x, 0.355, 0.010) + 1.20 * bump(x, 0.38, 0.011)
+                                  - 0.25 * bump(x, 0.405, 0.011) + 0.30 * bump(x, 0.62, 0.045));
+    }
+    return t;
+}
+
+//--> One pulse 0..1: systolic peak and the dicrotic wave after the notch
+static WaveTable buildPleth() {
+    WaveTable t;
+    double peak = 0.0;
+    for (size_t i = 0; i <= TABLE_SIZE; i++) {
+        double x = static_cast<double>(i) / TABLE_SIZE;
+        t[i] = static_cast<float>(bump(x, 0.18, 0.08) + 0.35 * bump(x, 0.48, 0.09));
+        peak = std::max(peak, static_cast<double>(t[i]));
+    }
+    for (float& v : t) v = static_cast<float>(v / peak);
+    return t;
+}
+
+//--> One breath 0..1: inspiration 40 % of the cycle, slower expiration
+static WaveTable buildResp() {
+    const double PI = 3.14159265358979323846;
+    WaveTable t;
+    for (size_t i = 0; i <= TABLE_SIZE; i++) {
+        double x = static_cast<double>(i) / TABLE_SIZE;
+        double v = x < 0.4 ? 0.5 - 0.5 * std::cos(PI * x / 0.4) : 0.5 + 0.5 * std::cos(PI * (x - 0.4) / 0.6);
+        t[i] = static_cast<float>(v);
+    }
+    return t;
+}
+
+static const WaveTable ECG_TABLE = buildEcg();
+static const WaveTable PLETH_TABLE = buildPleth();
+static const WaveTable RESP_TABLE = buildResp();
+
+//--> Table value at a phase in cycles, linear between the two nearest points
+static float lookup(const WaveTable& table, double phase) {
+    phase -= std::floor(phase);
+    double pos = phase * TABLE_SIZE;
+    size_t i = static_cast<size_t>(pos);
+    float frac = static_cast<float>(pos - i);
+    return table[i] + frac * (table[i + 1] - table[i]);
+}
+
+//--> Round and clamp to i16
+static int16_t toSample(float v) {
+    float r = std::round(v);
+    return static_cast<int16_t>(std::clamp(r, -32768.0f, 32767.0f));
+}
+
+//--> Constructor
+WaveformGenerator::WaveformGenerator(int64_t originUs, WaveformOptions opts)
+    : options(opts), originUs(originUs) {
+    //--> A frame has to hold a whole frame period of every wave, or the waves fall further behind every frame
+    uint16_t fastest = std::max({options.ecgRate, options.plethRate, options.respRate});
+    if (options.framePeriod.count() <= 0 || static_cast<uint64_t>(options.framePeriod.count()) * fastest / 1000 + 1 > WAVEFORM_MAX_SAMPLES) {
+        throw std::runtime_error("waveform frame period does not fit in one frame");
+    }
+    frameSeconds = std::chrono::duration<double>(options.framePeriod).count();
+    double tau = std::chrono::duration<double>(options.smoothing).count();
+    alpha = tau > 0.0 ? 1.0 - std::exp(-frameSeconds / tau) : 1.0;
+}
+
+//--> Samples of one wave whose time falls in the current frame
+template <typename Sample>
+void WaveformGenerator::fill(WaveformFrame& frame, Wave wave, uint16_t rate, Sample sample) {
+    size_t w = static_cast<size_t>(wave);
+    double frameStart = frameIndex * frameSeconds;
+
+    //--> Count from the totals, so rates that do not divide the frame period do not drift
+    uint64_t end = (frameIndex + 1) * static_cast<uint64_t>(options.framePeriod.count()) * rate / 1000;
+    size_t count = static_cast<size_t>(std::min<uint64_t>(end - emitted[w], WAVEFORM_MAX_SAMPLES));
+
+    frame.wave = wave;
+    frame.sampleRate = rate;
+    frame.sequence = sequence;
+    frame.timestampUs = originUs + static_cast<int64_t>(emitted[w] * 1e6 / rate);
+    frame.count = count;
+    for (size_t i = 0; i < count; i++) {
+        double offset = static_cast<double>(emitted[w] + i) / rate - frameStart;   // seconds into this frame
+        frame.samples[i] = toSample(sample(offset));
+    }
+    //--> Samples that did not fit lead the next frame, so none are skipped and the timestamps stay continuous
+    emitted[w] += count;
+}
+
+//--> Next frame of every wave
+void WaveformGenerator::generate(const WaveformInput& input, WaveformFrame frames[WAVE_COUNT]) {
+    double heartTarget = std::max(0.0f, input.heartRate) / 60.0;
+    double breathTarget = std::max(0.0f, input.breathRate) / 60.0;
+
+    //--> First frame starts at the requested rate, after that the rate follows smoothly
+    if (!started) {
+        heart.rate = heartTarget;
+        breath.rate = breathTarget;
+        started = true;
+    } else {
+        heart.rate += (heartTarget - heart.rate) * alpha;
+        breath.rate += (breathTarget - breath.rate) * alpha;
+    }
+
+    //--> Within a frame the rate is constant, so the phase of any sample follows from its time
+    double transit = std::chrono::duration<double>(options.pulseTransit).count();
+    const Oscillator h = heart, b = breath;
+
+    fill(frames[0], Wave::Ecg, options.ecgRate, [&](double t) {
+        return lookup(ECG_TABLE, h.phase + h.rate * t) * ECG_SCALE;
+    });
+    fill(frames[1], Wave::Pleth, options.plethRate, [&](double t) {
+        return lookup(PLETH_TABLE, h.phase + h.rate * (t - transit)) * UNIT_SCALE;
+    });
+    fill(frames[2], Wave::Resp, options.respRate, [&](double t) {
+        return lookup(RESP_TABLE, b.phase + b.rate * t) * UNIT_SCALE;
+    });
+
+    //--> Continue the phase where this frame ended
+    heart.phase = std::fmod(heart.phase + heart.rate * frameSeconds, 1.0);
+    breath.phase = std::fmod(breath.phase + breath.rate * frameSeconds, 1.0);
+    frameIndex++;
+    sequence++;
+}
+
+//--> Little-endian helpers
+static void putU16(uint8_t* p, uint16_t v) { p[0] = static_cast<uint8_t>(v); p[1] = static_cast<uint8_t>(v >> 8); }
+static void putU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+static void putU64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+static uint16_t getU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+static uint32_t getU32(const uint8_t* p) { uint32_t v = 0; for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i); return v; }
+static uint64_t getU64(const uint8_t* p) { uint64_t v = 0; for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i); return v; }
+
+//--> Header and i16 samples
+size_t encodeWaveform(uint8_t* out, size_t capacity, const WaveformFrame& frame) {
+    size_t size = WAVEFORM_HEADER_SIZE + 2 * frame.count;
+    if (frame.count > WAVEFORM_MAX_SAMPLES || size > capacity) return 0;
+
+    out[0] = TELEMETRY_MAGIC;
+    out[1] = TELEMETRY_VERSION;
+    out[2] = static_cast<uint8_t>(TelemetryType::Waveform);
+    out[3] = static_cast<uint8_t>(frame.wave);
+    putU32(out + 4, frame.sequence);
+    putU64(out + 8, static_cast<uint64_t>(frame.timestampUs));
+    putU16(out + 16, frame.sampleRate);
+    putU16(out + 18, static_cast<uint16_t>(frame.count));
+    for (size_t i = 0; i < frame.count; i++) putU16(out + WAVEFORM_HEADER_SIZE + 2 * i, static_cast<uint16_t>(frame.samples[i]));
+    return size;
+}
+
+//--> Check the header and read the samples back
+bool decodeWaveform(const uint8_t* data, size_t length, WaveformFrame& frame) {
+    if (length < WAVEFORM_HEADER_SIZE || data[0] != TELEMETRY_MAGIC || data[1] != TELEMETRY_VERSION) return false;
+    if (data[2] != static_cast<uint8_t>(TelemetryType::Waveform) || data[3] >= WAVE_COUNT) return false;
+
+    size_t count = getU16(data + 18);
+    if (count > WAVEFORM_MAX_SAMPLES || length < WAVEFORM_HEADER_SIZE + 2 * count) return false;
+
+    frame.wave = static_cast<Wave>(data[3]);
+    frame.sequence = getU32(data + 4);
+    frame.timestampUs = static_cast<int64_t>(getU64(data + 8));
+    frame.sampleRate = getU16(data + 16);
+    frame.count = count;
+    for (size_t i = 0; i < count; i++) frame.samples[i] = static_cast<int16_t>(getU16(data + WAVEFORM_HEADER_SIZE + 2 * i));
+    return true;
+}
+
+//--> Topic suffix
+const char* waveName(Wave wave) {
+    switch (wave) {
+        case Wave::Ecg: return "ecg";
+        case Wave::Pleth: return "pleth";
+        case Wave::Resp: return "resp";
+    }
+    return "unknown";
+}
@@ -0,0 +1,125 @@
+/*!
+ * \file      waveform.hpp
+ * \brief     ECG, pleth and respiration waveforms driven by the current vitals
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Every wave is one cycle stored as a table (built once at startup) and
+ * played back with a phase accumulator, so the heart and breath rate only
+ * change how fast the phase runs. Rate changes are smoothed with a time
+ * constant and the phase never jumps, so a change of heartbeat from 72 to
+ * 140 bpm speeds the trace up over a few seconds instead of cutting it.
+ * The pleth wave follows the same heart phase, delayed by the pulse transit
+ * time.
+ *
+ * Samples come out in frames: every call of generate() produces one frame of
+ * every wave covering the next frame period. A frame is sent as a binary
+ * payload, little-endian:
+ *
+ *   offset  size  field
+ *   0       1     magic 0xB7 (same as common/telemetry_codec.hpp)
+ *   1       1     format version, currently 1
+ *   2       1     record type 3 (TelemetryType::Waveform)
+ *   3       1     wave (Wave)
+ *   4       4     frame sequence number (u32, wraps)
+ *   8       8     time of the first sample, unix us (i64)
+ *   16      2     sample rate in Hz (u16)
+ *   18      2     number of samples N (u16)
+ *   20      2*N   samples as i16: ECG in uV, pleth and respiration in 1/10000
+ *
+ */
+
+#ifndef WAVEFORM_HPP
+#define WAVEFORM_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+//--> Waves, also the wave byte of a frame
+enum class Wave : uint8_t {
+    Ecg = 0,
+    Pleth = 1,
+    Resp = 2
+};
+const size_t WAVE_COUNT = 3;
+
+//--> Frame layout
+const size_t WAVEFORM_HEADER_SIZE = 20;
+const size_t WAVEFORM_MAX_SAMPLES = 512;        // per frame
+
+//--> Sample rates and frame period
+struct WaveformOptions {
+    uint16_t ecgRate = 250;                                 // Hz
+    uint16_t plethRate = 125;
+    uint16_t respRate = 125;
+    std::chrono::milliseconds framePeriod{200};
+    std::chrono::milliseconds smoothing{2000};              // time constant of rate changes
+    std::chrono::milliseconds pulseTransit{200};            // R wave to pleth upstroke
+};
+
+//--> What the waves follow
+struct WaveformInput {
+    float heartRate;        // beats per minute
+    float breathRate;       // breaths per minute
+};
+
+//--> One frame of one wave
+struct WaveformFrame {
+    Wave wave;
+    uint16_t sampleRate;
+    uint32_t sequence;
+    int64_t timestampUs;
+    size_t count;
+    int16_t samples[WAVEFORM_MAX_SAMPLES];
+};
+
+//--> Waveform engine of one patient
+class WaveformGenerator {
+
+//-> Public functions
+public:
+    //--> Constructor, originUs is the unix time of the first sample, throws when a frame period of a wave does not fit in WAVEFORM_MAX_SAMPLES
+    WaveformGenerator(int64_t originUs, WaveformOptions options = {});
+
+    //--> Produce the next frame period of every wave, frames is indexed by Wave
+    void generate(const WaveformInput& input, WaveformFrame frames[WAVE_COUNT]);
+
+    //--> Frame period
+    std::chrono::milliseconds framePeriod() const { return options.framePeriod; }
+
+//-> Private functions and variables
+private:
+    //--> Phase in cycles (0..1) and smoothed rate in cycles per second
+    struct Oscillator {
+        double phase = 0.0;
+        double rate = 0.0;
+    };
+
+    WaveformOptions options;
+    int64_t originUs;
+    double frameSeconds;
+    double alpha;                       // rate smoothing per frame
+    bool started = false;
+    uint32_t sequence = 0;
+    uint64_t frameIndex = 0;
+    uint64_t emitted[WAVE_COUNT] = {};  // samples per wave so far
+    Oscillator heart;
+    Oscillator breath;
+
+    //--> Fill one frame, sample value from the phase of its own time
+    template <typename Sample>
+    void fill(WaveformFrame& frame, Wave wave, uint16_t rate, Sample sample);
+};
+
+//--> Encode a frame, returns bytes written or 0 when it does not fit
+size_t encodeWaveform(uint8_t* out, size_t capacity, const WaveformFrame& frame);
+
+//--> Decode a frame, false when it is not a waveform frame of this version
+bool decodeWaveform(const uint8_t* data, size_t length, WaveformFrame& frame);
+
+//--> Topic suffix of a wave ("ecg", "pleth", "resp")
+const char* waveName(Wave wave);
+
+#endif //--> WAVEFORM_HPP
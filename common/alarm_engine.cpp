@@ -0,0 +1,144 @@
+/*!
+ * \file      alarm_engine.cpp
+ * \brief     Edge rule engine that turns a stream of samples into alarm events
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "alarm_engine.hpp"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+const int64_t NOT_OVER = std::numeric_limits<int64_t>::max();
+
+//--> Next word of a line, leading spaces skipped
+static std::string_view nextWord(std::string_view& line) {
+    while (!line.empty() && std::isspace(static_cast<unsigned char>(line.front()))) line.remove_prefix(1);
+    size_t end = 0;
+    while (end < line.size() && !std::isspace(static_cast<unsigned char>(line[end]))) end++;
+    std::string_view word = line.substr(0, end);
+    line.remove_prefix(end);
+    return word;
+}
+
+//--> Whole word as a number
+static bool parseNumber(std::string_view text, double& value) {
+    auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc() && end == text.data() + text.size();
+}
+
+//--> Constructor, one line at a time into the flat rule array
+AlarmEngine::AlarmEngine(std::string_view text, const std::string_view* fieldNames, size_t fieldCount, std::chrono::milliseconds rateSmoothing)
+    : fields(fieldCount), smoothingUs(std::chrono::duration<double, std::micro>(rateSmoothing).count()) {
+    for (int lineNumber = 1; !text.empty(); lineNumber++) {
+        size_t newline = text.find('\n');
+        std::string_view line = text.substr(0, newline);
+        text.remove_prefix(newline == std::string_view::npos ? text.size() : newline + 1);
+        line = line.substr(0, line.find('#'));
+
+        std::string_view name = nextWord(line);
+        if (name.empty()) continue;
+        std::string where = "alarm rule line " + std::to_string(lineNumber) + " (" + std::string(name) + "): ";
+
+        //--> Value the rule watches
+        std::string_view word = nextWord(line);
+        size_t field = 0;
+        while (field < fields && fieldNames[field] != word) field++;
+        if (field == fields) throw std::runtime_error(where + "unknown value '" + std::string(word) + "'");
+
+        //--> Condition and limit
+        std::string_view kind = nextWord(line);
+        bool rate = kind == "rising" || kind == "falling";
+        bool up = kind == "above" || kind == "rising";
+        if (!rate && !up && kind != "below") throw std::runtime_error(where + "expected above, below, rising or falling");
+        double limit;
+        if (!parseNumber(nextWord(line), limit)) throw std::runtime_error(where + "bad limit");
+
+        //--> Optional hysteresis and duration
+        double clear = limit;
+        double holdSeconds = 0.0;
+        for (word = nextWord(line); !word.empty(); word = nextWord(line)) {
+            double number;
+            if (!parseNumber(nextWord(line), number)) throw std::runtime_error(where + "bad number after " + std::string(word));
+            if (word == "clear") clear = number;
+            else if (word == "for" && number >= 0.0) holdSeconds = number;
+            else throw std::runtime_error(where + "unexpected '" + std::string(word) + "'");
+        }
+
+        //--> below becomes above on the negated level, falling becomes rising on the negated rate (limits of rates are speeds, always positive)
+        float sign = up ? 1.0f : -1.0f;
+        float scale = rate ? 1.0f : sign;
+        Rule rule{static_cast<uint32_t>(rate ? fields + field : field), sign, static_cast<float>(scale * limit),
+                  static_cast<float>(scale * clear), static_cast<int64_t>(holdSeconds * 1e6), static_cast<float>(limit)};
+        if (rule.clear > rule.raise) throw std::runtime_error(where + "clear level is on the wrong side of the limit");
+
+        rules.push_back(rule);
+        names.emplace_back(name);
+    }
+
+    overSince.assign(rules.size(), NOT_OVER);
+    activeFlags.assign(rules.size(), 0);
+    inputs.assign(2 * fields, 0.0f);
+    previous.assign(fields, 0.0f);
+}
+
+//--> Update levels and rates, then run every rule
+size_t AlarmEngine::evaluate(int64_t timestampUs, const float* values, AlarmEvent* events) {
+    //--> Rate per minute, smoothed so sensor noise between close samples does not look like a fast change
+    if (started && timestampUs > previousUs) {
+        double dt = static_cast<double>(timestampUs - previousUs);
+        float alpha = static_cast<float>(smoothingUs > 0.0 ? 1.0 - std::exp(-dt / smoothingUs) : 1.0);
+        for (size_t f = 0; f < fields; f++) {
+            float perMinute = static_cast<float>((values[f] - previous[f]) * 60e6 / dt);
+            inputs[fields + f] += (perMinute - inputs[fields + f]) * alpha;
+        }
+    }
+    std::copy(values, values + fields, inputs.begin());
+    std::copy(values, values + fields, previous.begin());
+    previousUs = timestampUs;
+    started = true;
+    evaluations++;
+
+    size_t count = 0;
+    for (size_t i = 0; i < rules.size(); i++) {
+        const Rule& r = rules[i];
+        float m = r.sign * inputs[r.input];
+        bool over = m > r.raise;
+
+        //--> Start of the violation is kept while it lasts
+        overSince[i] = over ? std::min(overSince[i], timestampUs) : NOT_OVER;
+        bool raise = !activeFlags[i] & over & (timestampUs - overSince[i] >= r.holdUs);
+        bool clear = activeFlags[i] & (m < r.clear);
+
+        //--> Only transitions leave the loop body
+        if (raise | clear) {
+            activeFlags[i] = raise;
+            events[count++] = AlarmEvent{i, raise, inputs[r.input], r.limit, timestampUs};
+            if (raise) raised++;
+            else cleared++;
+        }
+    }
+    return count;
+}
+
+//--> Copy of the counters
+AlarmMetrics AlarmEngine::metrics() const {
+    size_t active = static_cast<size_t>(std::count(activeFlags.begin(), activeFlags.end(), 1));
+    return AlarmMetrics{evaluations, raised, cleared, active};
+}
+
+//--> Whole file as text
+std::string readAlarmRules(const std::string& path) {
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("cannot open alarm rules: " + path);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
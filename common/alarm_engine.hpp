@@ -0,0 +1,117 @@
+/*!
+ * \file      alarm_engine.hpp
+ * \brief     Edge rule engine that turns a stream of samples into alarm events
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Rules are text, one per line, read once at startup:
+ *
+ *   # name        value            condition
+ *   spo2_low      bloodoxygen      below 90  clear 92  for 10
+ *   temp_high     bodytemperature  above 38.5 clear 38.2
+ *   bp_falling    bloodpressure    falling 20 for 10
+ *
+ *   above / below <limit>     level of the value
+ *   rising / falling <limit>  rate of change in units per minute (smoothed)
+ *   clear <level>             hysteresis: the alarm only clears past this level
+ *                             (default: the limit itself)
+ *   for <seconds>             the condition has to hold this long before the
+ *                             alarm is raised (default 0)
+ *
+ * Every rule is compiled into one flat entry (input index, sign, raise and
+ * clear level, hold time), below and falling are turned into above and
+ * rising by flipping the sign. Evaluating a sample is then the same few
+ * compares for every rule, without a switch on the kind of rule. Only
+ * transitions are reported: one event when an alarm is raised and one when
+ * it clears.
+ *
+ */
+
+#ifndef ALARM_ENGINE_HPP
+#define ALARM_ENGINE_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+//--> One raise or clear
+struct AlarmEvent {
+    size_t rule;                // index of the rule
+    bool active;                // true = raised, false = cleared
+    float value;                // level or rate (per minute) that caused it
+    float limit;                // limit of the rule as written
+    int64_t timestampUs;        // time of the sample
+};
+
+//--> Engine counters
+struct AlarmMetrics {
+    uint64_t evaluations;       // samples evaluated
+    uint64_t raised;
+    uint64_t cleared;
+    size_t active;              // alarms active now
+};
+
+//--> Rules compiled from text, evaluated on every sample
+class AlarmEngine {
+
+//-> Public functions
+public:
+    //--> Constructor, compiles the rules, field names are the value names allowed in them (throws std::runtime_error)
+    AlarmEngine(std::string_view rules, const std::string_view* fields, size_t fieldCount,
+                std::chrono::milliseconds rateSmoothing = std::chrono::seconds(10));
+
+    //--> Evaluate one sample (one value per field), writes at most size() events, returns how many
+    size_t evaluate(int64_t timestampUs, const float* values, AlarmEvent* events);
+
+    //--> Number of rules
+    size_t size() const { return rules.size(); }
+
+    //--> Name of a rule
+    const std::string& name(size_t rule) const { return names[rule]; }
+
+    //--> True while the alarm of a rule is raised
+    bool active(size_t rule) const { return activeFlags[rule] != 0; }
+
+    //--> Current counters
+    AlarmMetrics metrics() const;
+
+//-> Private functions and variables
+private:
+    //--> One rule after compiling: sign * input > raise raises, sign * input < clear clears
+    struct Rule {
+        uint32_t input;         // field for a level, fieldCount + field for a rate
+        float sign;             // +1 above / rising, -1 below / falling
+        float raise;
+        float clear;
+        int64_t holdUs;
+        float limit;            // as written, for the events
+    };
+
+    size_t fields;
+    double smoothingUs;
+    std::vector<Rule> rules;
+    std::vector<std::string> names;
+
+    //--> Per rule state
+    std::vector<int64_t> overSince;         // start of the current violation, INT64_MAX when none
+    std::vector<uint8_t> activeFlags;
+
+    //--> Levels followed by rates, indexed by Rule::input
+    std::vector<float> inputs;
+    std::vector<float> previous;
+    int64_t previousUs = 0;
+    bool started = false;
+
+    uint64_t evaluations = 0;
+    uint64_t raised = 0;
+    uint64_t cleared = 0;
+};
+
+//--> Read a rule file into text for the constructor (throws std::runtime_error)
+std::string readAlarmRules(const std::string& path);
+
+#endif //--> ALARM_ENGINE_HPP
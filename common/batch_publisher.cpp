@@ -0,0 +1,84 @@
+/*!
+ * \file      batch_publisher.cpp
+ * \brief     Collects samples per topic and publishes them as one message
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "batch_publisher.hpp"
+#include "clock.hpp"
+
+//--> Constructor
+BatchPublisher::BatchPublisher(InflightPublisher& publisher, int qos) : publisher(publisher), qos(qos) { }
+
+//--> Limits per topic, an open batch goes out first so it keeps the framing it was started with
+void BatchPublisher::setLimits(const std::string& topic, BatchLimits limits) {
+    Batch& batch = batches[topic];
+    if (batch.count) send(topic, batch);
+    batch.limits = limits;
+}
+
+//--> Append to the batch of the topic
+void BatchPublisher::add(const std::string& topic, std::string_view sample) {
+    Batch& batch = batches[topic];
+    int64_t now = monotonicNs();
+
+    //--> No batching for this topic
+    if (batch.limits.maxSamples <= 1) {
+        auto msg = mqtt::make_message(topic, std::string(sample));
+        msg->set_qos(qos);
+        publisher.publish(msg);
+        return;
+    }
+
+    //--> Guess when the next sample comes from the last interval, unknown after the first sample
+    bool known = batch.lastNs != 0;
+    int64_t interval = known ? now - batch.lastNs : 0;
+
+    bool json = batch.limits.framing == BatchFraming::JsonArray;
+    if (batch.count == 0) {
+        batch.body = json ? "{\"samples\":[" : "";
+        batch.firstNs = now;
+    } else if (json) {
+        batch.body += ',';
+    }
+    batch.body += sample;
+    batch.count++;
+    batch.lastNs = now;
+
+    //--> Full, the next sample would arrive after the oldest one expired, or nobody knows when it arrives
+    int64_t maxAgeNs = std::chrono::nanoseconds(batch.limits.maxAge).count();
+    if (!known || batch.count >= batch.limits.maxSamples || now + interval - batch.firstNs >= maxAgeNs) {
+        send(topic, batch);
+    }
+}
+
+//--> Age based flush
+void BatchPublisher::poll() {
+    int64_t now = monotonicNs();
+    for (auto& entry : batches) {
+        Batch& batch = entry.second;
+        if (batch.count && now - batch.firstNs >= std::chrono::nanoseconds(batch.limits.maxAge).count()) {
+            send(entry.first, batch);
+        }
+    }
+}
+
+//--> Send all open batches
+void BatchPublisher::flush() {
+    for (auto& entry : batches) {
+        if (entry.second.count) send(entry.first, entry.second);
+    }
+}
+
+//--> One message for the whole batch
+void BatchPublisher::send(const std::string& topic, Batch& batch) {
+    if (batch.limits.framing == BatchFraming::JsonArray) batch.body += "]}";
+    auto msg = mqtt::make_message(topic, batch.body);
+    msg->set_qos(qos);
+    publisher.publish(msg);
+
+    batch.count = 0;
+    batch.body.clear();
+}
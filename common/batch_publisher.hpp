@@ -0,0 +1,82 @@
+/*!
+ * \file      batch_publisher.hpp
+ * \brief     Collects samples per topic and publishes them as one message
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Every topic has its own limits: a batch is sent when it holds maxSamples
+ * samples or when waiting for the next sample would make the oldest one older
+ * than maxAge. The very first sample of a topic goes out on its own, the time
+ * to the next one is not known yet and it must not wait a whole maxAge.
+ *
+ * A topic keeps one payload shape. With limits every message is
+ * {"samples":[{...},{...}]}, also a batch of one, where every element is the
+ * JSON object the caller passed in (with its own seq and ts_us). Binary
+ * records (see telemetry_codec.hpp) are simply put back to back. Topics
+ * without limits are published one flat sample per message, as before.
+ *
+ */
+
+#ifndef BATCH_PUBLISHER_HPP
+#define BATCH_PUBLISHER_HPP
+
+#include "inflight_publisher.hpp"
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+//--> How samples are put together in one message
+enum class BatchFraming {
+    JsonArray,          // {"samples":[a,b,c]}
+    Concatenate         // abc, for self delimiting binary records
+};
+
+//--> When to send a batch
+struct BatchLimits {
+    size_t maxSamples = 1;                          // 1 = no batching
+    std::chrono::milliseconds maxAge{0};            // max wait of the oldest sample
+    BatchFraming framing = BatchFraming::JsonArray;
+};
+
+//--> Per topic sample batching on top of the in-flight publisher
+class BatchPublisher {
+
+//-> Public functions
+public:
+    //--> Constructor
+    BatchPublisher(InflightPublisher& publisher, int qos);
+
+    //--> Set the limits of one topic, call before the first add(), an open batch is sent first
+    void setLimits(const std::string& topic, BatchLimits limits);
+
+    //--> Add one sample (JSON object or binary record), sends the batch when a limit is reached
+    void add(const std::string& topic, std::string_view sample);
+
+    //--> Send batches whose oldest sample reached max age, call this every loop
+    void poll();
+
+    //--> Send everything that is waiting
+    void flush();
+
+//-> Private functions and variables
+private:
+    struct Batch {
+        BatchLimits limits;
+        std::string body;
+        size_t count = 0;
+        int64_t firstNs = 0;        // CLOCK_MONOTONIC of the oldest sample in the batch
+        int64_t lastNs = 0;         // CLOCK_MONOTONIC of the last add, to guess the next one
+    };
+
+    InflightPublisher& publisher;
+    int qos;
+    std::map<std::string, Batch> batches;
+
+    //--> Close the array and publish
+    void send(const std::string& topic, Batch& batch);
+};
+
+#endif //--> BATCH_PUBLISHER_HPP
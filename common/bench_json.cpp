@@ -0,0 +1,72 @@
+/*!
+ * \file      bench_json.cpp
+ * \brief     Benchmark of the telemetry payload serializers
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Formats the sensor record the old way (std::ostringstream) and with
+ * JsonWriter and prints the time per record of both.
+ *
+ * command used to compile:  g++ -O2 -std=c++17 bench_json.cpp -o bench_json  then to run: ./bench_json
+ */
+
+#include "json_writer.hpp"
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+//--> Same fields as the sensor payload
+inline constexpr JsonField SENSOR_FIELDS[] = {
+    {"seq", 0}, {"ts_us", 0}, {"temperature", 2}, {"humidity", 2}, {"pressure", 2}
+};
+
+const int ITERATIONS = 1000000;
+
+//--> Keeps the compiler from optimising the work away
+static size_t sink = 0;
+
+//--> Old publishData payload
+double benchOstringstream() {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::ostringstream payload;
+        payload << "{"
+                << "\"seq\":" << static_cast<uint64_t>(i) << ","
+                << "\"ts_us\":" << 1760000000000000LL + i << ","
+                << "\"temperature\":" << 21.37f + i * 1e-4f << ","
+                << "\"humidity\":" << 45.12f << ","
+                << "\"pressure\":" << 1013.25f
+                << "}";
+        sink += payload.str().size();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ITERATIONS;
+}
+
+//--> New serializer
+double benchJsonWriter() {
+    JsonWriter<256> writer;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        std::string_view json = writer.record<SENSOR_FIELDS>(static_cast<uint64_t>(i), 1760000000000000LL + i,
+                                                             21.37f + i * 1e-4f, 45.12f, 1013.25f);
+        sink += json.size();
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / ITERATIONS;
+}
+
+int main() {
+    //--> Show one record of each so the output can be compared
+    JsonWriter<256> writer;
+    std::cout << "JsonWriter output: " << writer.record<SENSOR_FIELDS>(uint64_t{1}, 1760000000000000LL, 21.37f, 45.12f, 1013.25f) << std::endl;
+
+    double old = benchOstringstream();
+    double now = benchJsonWriter();
+    std::cout << "ostringstream: " << old << " ns/record" << std::endl;
+    std::cout << "JsonWriter:    " << now << " ns/record" << std::endl;
+    std::cout << "speedup:       " << old / now << "x" << std::endl;
+    return sink == 0;
+}
@@ -0,0 +1,182 @@
+/*!
+ * \file      bench_timeseries.cpp
+ * \brief     Size and speed of the local time-series store for a fleet of BME280 sensors
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Simulates SENSORS sensors sampled at 1 Hz for DAYS days (as fast as
+ * possible, with synthetic timestamps) and stores them like Opdracht_5 does:
+ * temperature, humidity and pressure at 0.01 resolution. The samples follow
+ * a slow random walk with sensor noise and the timestamps have up to 200 us
+ * of wake-up jitter, like the real sample loop.
+ *
+ * Prints bytes per sample against the 20 raw bytes, the size of one day,
+ * the number of write + sync cycles and the append cost.
+ *
+ * Then queries one sensor with TimeSeriesReader (timeseries_reader.hpp):
+ * min/max/mean of the last hour, the last day and everything, and the raw
+ * samples of the last hour and the last day. The first query of each kind
+ * opens the segments on a new reader (cold, the page cache is warm after
+ * writing), the rest are repeats on the same reader. The everything
+ * aggregate is checked against one computed from all raw samples.
+ *
+ * command used to compile:  g++ -O2 -std=c++17 bench_timeseries.cpp timeseries_store.cpp timeseries_index.cpp timeseries_reader.cpp -o bench_timeseries -pthread
+ * then to run: ./bench_timeseries [--sensors 40] [--days 7]   (--days 31 for queries over a month)
+ */
+
+#include "clock.hpp"
+#include "timeseries_reader.hpp"
+#include "timeseries_store.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+#include <dirent.h>
+#include <unistd.h>
+
+const std::string DIRECTORY{"bench_timeseries.tmp"};
+const int64_t SAMPLE_US = 1000000;
+const int64_t JITTER_US = 200;
+const int64_t HOUR_US = 3600 * SAMPLE_US;
+const int REPEATS = 50;
+
+//--> Remove the segment files of a run
+static void removeSegments() {
+    if (DIR* dir = opendir(DIRECTORY.c_str())) {
+        while (dirent* entry = readdir(dir)) {
+            if (entry->d_name[0] != '.') unlink((DIRECTORY + "/" + entry->d_name).c_str());
+        }
+        closedir(dir);
+    }
+    rmdir(DIRECTORY.c_str());
+}
+
+//--> Time one query: the first run on a new reader, then the average of the repeats on the same one
+template <typename Query>
+static void measure(const char* name, Query query) {
+    TimeSeriesReader reader(DIRECTORY);
+    int64_t before = monotonicNs();
+    size_t result = query(reader);
+    int64_t coldNs = monotonicNs() - before;
+    before = monotonicNs();
+    for (int i = 0; i < REPEATS; i++) query(reader);
+    int64_t warmNs = (monotonicNs() - before) / REPEATS;
+    TimeSeriesQueryMetrics m = reader.metrics();
+    std::printf("  %-22s %9.3f ms cold, %9.3f ms warm, %8zu samples, %llu segments (%llu indexed), %llu blocks summarised, %llu decoded\n",
+                name, coldNs / 1e6, warmNs / 1e6, result, static_cast<unsigned long long>(m.segments),
+                static_cast<unsigned long long>(m.sealed), static_cast<unsigned long long>(m.summarised / (REPEATS + 1)),
+                static_cast<unsigned long long>(m.decoded / (REPEATS + 1)));
+}
+
+//--> One simulated sensor, a random walk around a set point
+struct Sensor {
+    uint16_t series;
+    float temperature;
+    float humidity;
+    float pressure;
+};
+
+int main(int argc, char* argv[]) {
+    int sensors = 40;
+    int days = 7;
+    for (int i = 1; i + 1 < argc; i++) {
+        if (std::strcmp(argv[i], "--sensors") == 0) sensors = std::atoi(argv[i + 1]);
+        else if (std::strcmp(argv[i], "--days") == 0) days = std::atoi(argv[i + 1]);
+    }
+
+    removeSegments();
+    TimeSeriesOptions options;
+    options.directory = DIRECTORY;
+    TimeSeriesStore store(options);
+
+    std::mt19937 random(42);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::uniform_int_distribution<int64_t> jitter(0, JITTER_US);
+
+    std::vector<Sensor> fleet;
+    for (int s = 0; s < sensors; s++) {
+        uint16_t id = store.addSeries("bme280-" + std::to_string(s), {"temperature", "humidity", "pressure"}, {100, 100, 100});
+        fleet.push_back({id, 20.0f + s % 5, 45.0f + s % 10, 1013.0f});
+    }
+
+    //--> Start at midnight so the days line up with the segments
+    int64_t startUs = wallMicros(monotonicNs()) / 86400000000LL * 86400000000LL;
+    int64_t seconds = static_cast<int64_t>(days) * 86400;
+    std::vector<float> values(fleet.size() * 3);
+    std::vector<int64_t> stamps(fleet.size());
+    int64_t appendNs = 0;
+    int64_t begin = monotonicNs();
+    for (int64_t t = 0; t < seconds; t++) {
+        //--> Slow drift plus noise of a few steps of the 0.01 resolution, generated outside the timing
+        for (size_t i = 0; i < fleet.size(); i++) {
+            Sensor& s = fleet[i];
+            s.temperature += 0.002f * noise(random);
+            s.humidity += 0.01f * noise(random);
+            s.pressure += 0.002f * noise(random);
+            values[3 * i] = s.temperature + 0.02f * noise(random);
+            values[3 * i + 1] = s.humidity + 0.05f * noise(random);
+            values[3 * i + 2] = s.pressure + 0.02f * noise(random);
+            stamps[i] = startUs + t * SAMPLE_US + jitter(random);
+        }
+
+        //--> One second of the whole fleet
+        int64_t before = monotonicNs();
+        for (size_t i = 0; i < fleet.size(); i++) store.append(fleet[i].series, stamps[i], &values[3 * i]);
+        appendNs += monotonicNs() - before;
+    }
+    store.flush();
+    int64_t totalNs = monotonicNs() - begin;
+
+    TimeSeriesMetrics m = store.metrics();
+    std::printf("%d sensors x %d days at 1 Hz: %llu samples in %llu blocks\n", sensors, days,
+                static_cast<unsigned long long>(m.samples), static_cast<unsigned long long>(m.blocks));
+    std::printf("  on disk:   %.2f bytes per sample (raw %.0f), %.1fx smaller, %.1f MB per day\n",
+                static_cast<double>(m.bytes) / m.samples, static_cast<double>(m.rawBytes) / m.samples,
+                static_cast<double>(m.rawBytes) / m.bytes, m.bytes / 1e6 / days);
+    std::printf("  writes:    %llu write + sync cycles in %llu segments, max %lld us, %llu dropped\n",
+                static_cast<unsigned long long>(m.writes), static_cast<unsigned long long>(m.segments),
+                static_cast<long long>(m.maxWriteUs), static_cast<unsigned long long>(m.dropped));
+    std::printf("  append:    %.1f ns per sample, %.2f s in total with the simulation and the writes\n",
+                static_cast<double>(appendNs) / m.samples, totalNs / 1e9);
+
+    //--> Queries on the first sensor, up to its last sample
+    const std::string series = "bme280-0";
+    int64_t endUs = startUs + seconds * SAMPLE_US;
+    std::printf("queries on %s, %llu index files\n", series.c_str(), static_cast<unsigned long long>(m.sealed));
+    TimeSeriesStats stats[3];
+    auto aggregate = [&](int64_t fromUs) {
+        return [&, fromUs](TimeSeriesReader& reader) {
+            reader.aggregate(series, fromUs, endUs, stats);
+            return static_cast<size_t>(stats[0].count);
+        };
+    };
+    auto samples = [&](int64_t fromUs) {
+        return [&, fromUs](TimeSeriesReader& reader) { return reader.samples(series, fromUs, endUs, [](int64_t, const float*) {}); };
+    };
+    measure("aggregate last hour", aggregate(endUs - HOUR_US));
+    measure("aggregate last day", aggregate(endUs - 24 * HOUR_US));
+    measure("aggregate everything", aggregate(startUs));
+    measure("samples last hour", samples(endUs - HOUR_US));
+    measure("samples last day", samples(endUs - 24 * HOUR_US));
+
+    //--> The summaries have to give what the raw samples give
+    TimeSeriesReader reader(DIRECTORY);
+    reader.aggregate(series, startUs + HOUR_US / 2, endUs, stats);
+    double min = INFINITY, max = -INFINITY, sum = 0.0;
+    size_t count = reader.samples(series, startUs + HOUR_US / 2, endUs, [&](int64_t, const float* v) {
+        min = std::min(min, static_cast<double>(v[0]));
+        max = std::max(max, static_cast<double>(v[0]));
+        sum += v[0];
+    });
+    bool same = count == stats[0].count && std::fabs(min - stats[0].min) < 1e-4 && std::fabs(max - stats[0].max) < 1e-4 &&
+                std::fabs(sum / count - stats[0].mean) < 1e-4;
+    std::printf("  check: %zu samples, temperature min %.2f max %.2f mean %.4f, %s\n", count, stats[0].min, stats[0].max,
+                stats[0].mean, same ? "same as from the raw samples" : "DIFFERENT from the raw samples");
+    removeSegments();
+    return 0;
+}
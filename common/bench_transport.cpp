@@ -0,0 +1,126 @@
+/*!
+ * \file      bench_transport.cpp
+ * \brief     Benchmark of the publish pipeline without a broker (loopback transport)
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Splits the cost of one vitals record over the stages of the pipeline:
+ *
+ *   format      JsonWriter / encodeTelemetry only
+ *   + queue     format, publish into the LoopbackTransport and deliver on the same thread (poll)
+ *   + thread    format and publish here, delivery thread decodes it on another core
+ *   latency     same, paced at 100k records/s so the queue stays short, publish ->
+ *               handler latency from an HDR histogram
+ *
+ * The difference between the lines is what the transport costs, the broker
+ * and network come on top of this and are measured by
+ * Opdracht_5/bench_latency.cpp.
+ *
+ * command used to compile:  g++ -O2 -std=c++17 bench_transport.cpp loopback_transport.cpp telemetry_codec.cpp hdr_histogram.cpp -o bench_transport -pthread  then to run: ./bench_transport
+ */
+
+#include "clock.hpp"
+#include "hdr_histogram.hpp"
+#include "json_writer.hpp"
+#include "loopback_transport.hpp"
+#include "telemetry_codec.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+//--> Same record as the PROG6 monitor
+inline constexpr JsonField VITALS_FIELDS[] = {
+    {"seq", 0}, {"ts_us", 0}, {"heartbeat", 1}, {"bloodpressure", 1}, {"bloodoxygen", 1}, {"breathspeed", 1}, {"bodytemperature", 1}
+};
+const std::string TOPIC{"current"};
+
+const int RECORDS = 1000000;
+const int LATENCY_RECORDS = 200000;
+const int64_t LATENCY_GAP_NS = 10000;           // 100k records/s
+
+//--> Keeps the compiler from optimising the work away
+static std::atomic<size_t> sink{0};
+
+//--> One record in the chosen format, the timestamp field carries the send time in ns for the latency
+static std::string formatRecord(JsonWriter<256>& json, bool binary, uint64_t seq, int64_t stampNs) {
+    const float values[5] = { 72.0f + (seq % 7), 120.0f, 98.0f, 16.0f, 36.8f };
+    if (!binary) return std::string(json.record<VITALS_FIELDS>(seq, stampNs, values[0], values[1], values[2], values[3], values[4]));
+
+    uint8_t record[TELEMETRY_HEADER_SIZE + 5 * 4];
+    size_t size = encodeTelemetry(record, sizeof(record), TelemetryType::Vitals, static_cast<uint32_t>(seq), stampNs, values, 5);
+    return std::string(reinterpret_cast<const char*>(record), size);
+}
+
+//--> Time per record of one mode in ns
+template <typename Step>
+static double timePerRecord(Step step) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < RECORDS; i++) step(static_cast<uint64_t>(i));
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / RECORDS;
+}
+
+//--> All three stages for one format
+static void run(bool binary) {
+    JsonWriter<256> json;
+    const char* name = binary ? "binary" : "json";
+
+    //--> Formatting alone
+    double format = timePerRecord([&](uint64_t seq) { sink += formatRecord(json, binary, seq, 0).size(); });
+
+    //--> Through the queue and back on this thread
+    LoopbackTransport inline_(false);
+    inline_.attach(TOPIC, [](std::string_view, std::string_view payload) { sink += payload.size(); });
+    double queued = timePerRecord([&](uint64_t seq) {
+        inline_.publish(TOPIC, formatRecord(json, binary, seq, 0), 0);
+        inline_.poll();
+    });
+
+    //--> Delivery thread on another core, latency from the stamp in the record
+    HdrHistogram latencyNs(10000000000LL, 3);
+    LoopbackTransport threaded(true);
+    threaded.attach(TOPIC, [&](std::string_view, std::string_view payload) {
+        int64_t stamp = 0;
+        if (binary) {
+            TelemetryRecord record;
+            size_t used;
+            if (decodeTelemetry(reinterpret_cast<const uint8_t*>(payload.data()), payload.size(), record, used)) stamp = record.timestampUs;
+        } else {
+            size_t at = payload.find("\"ts_us\":");
+            if (at != std::string_view::npos) std::from_chars(payload.data() + at + 8, payload.data() + payload.size(), stamp);
+        }
+        latencyNs.record(monotonicNs() - stamp);
+    });
+    threaded.start();
+    double pipelined = timePerRecord([&](uint64_t seq) { threaded.publish(TOPIC, formatRecord(json, binary, seq, monotonicNs()), 0); });
+
+    //--> Flat out the queue is always full and the latency is only queueing, so measure it paced
+    for (LoopbackMetrics m = threaded.metrics(); m.delivered < m.published; m = threaded.metrics()) std::this_thread::yield();
+    latencyNs.reset();
+    int64_t next = monotonicNs();
+    for (int i = 0; i < LATENCY_RECORDS; i++) {
+        while (monotonicNs() < next) std::this_thread::yield();
+        next += LATENCY_GAP_NS;
+        threaded.publish(TOPIC, formatRecord(json, binary, static_cast<uint64_t>(i), monotonicNs()), 0);
+    }
+    threaded.stop();
+    LoopbackMetrics m = threaded.metrics();
+
+    std::printf("%s, %d records\n", name, RECORDS);
+    std::printf("  format only:           %7.1f ns/record\n", format);
+    std::printf("  + loopback, same core: %7.1f ns/record  (%.1f M records/s)\n", queued, 1000.0 / queued);
+    std::printf("  + delivery thread:     %7.1f ns/record  (%.1f M records/s), %llu delivered\n", pipelined, 1000.0 / pipelined,
+                static_cast<unsigned long long>(m.delivered));
+    std::printf("  latency at 100k/s, publish -> handler: p50 %lld ns, p99 %lld ns, p99.9 %lld ns, max %lld ns\n",
+                static_cast<long long>(latencyNs.percentile(50.0)), static_cast<long long>(latencyNs.percentile(99.0)),
+                static_cast<long long>(latencyNs.percentile(99.9)), static_cast<long long>(latencyNs.max()));
+}
+
+int main() {
+    run(false);
+    run(true);
+    return sink == 0;
+}
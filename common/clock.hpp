@@ -0,0 +1,45 @@
+/*!
+ * \file      clock.hpp
+ * \brief     Monotonic timestamps and mapping them to wall-clock time
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Samples are stamped with CLOCK_MONOTONIC so intervals stay correct when NTP
+ * steps the clock (the Pi has no RTC, so that happens after every boot).
+ * Only when a sample leaves the program it is mapped to wall-clock time with
+ * the current offset between CLOCK_REALTIME and CLOCK_MONOTONIC.
+ *
+ */
+
+#ifndef CLOCK_HPP
+#define CLOCK_HPP
+
+#include <cstdint>
+#include <time.h>
+
+//--> Current CLOCK_MONOTONIC time in ns
+inline int64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//--> Current CLOCK_REALTIME time in ns since the unix epoch
+inline int64_t wallNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+//--> Map a CLOCK_MONOTONIC stamp to unix time in us
+inline int64_t wallMicros(int64_t monoNs) {
+    //--> Monotonic read twice around the wall read, the midpoint halves the error
+    int64_t before = monotonicNs();
+    int64_t wall = wallNs();
+    int64_t after = monotonicNs();
+    int64_t offset = wall - (before + (after - before) / 2);
+    return (monoNs + offset) / 1000;
+}
+
+#endif //--> CLOCK_HPP
@@ -0,0 +1,183 @@
+/*!
+ * \file      connection_manager.cpp
+ * \brief     Keeps the mqtt connection up from its own thread
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "connection_manager.hpp"
+#include <algorithm>
+#include <random>
+
+//--> Constructor
+ConnectionManager::ConnectionManager(mqtt::async_client& client, mqtt::connect_options options, ReconnectOptions reconnect)
+    : client(client), connectOptions(std::move(options)), reconnectOptions(reconnect) {
+    //--> Persistent session, the broker keeps subscriptions and QoS1 state while we are away
+    if (connectOptions.get_mqtt_version() == MQTTVERSION_5) connectOptions.set_clean_start(false);
+    else connectOptions.set_clean_session(false);
+    client.set_callback(*this);
+}
+
+//--> Destructor
+ConnectionManager::~ConnectionManager() {
+    stop();
+}
+
+//--> Remember the subscription and send it right away when connected
+void ConnectionManager::addSubscription(const std::string& topic, int qos) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        subscriptions.emplace_back(topic, qos);
+    }
+    if (client.is_connected()) {
+        try {
+            client.subscribe(topic, qos);
+        } catch (const mqtt::exception&) {
+            //--> Sent again on the next connect
+        }
+    }
+}
+
+//--> Incoming messages go to the application handler
+void ConnectionManager::setMessageHandler(mqtt::callback* h) {
+    handler = h;
+}
+
+//--> Hook for per-connection state such as topic aliases
+void ConnectionManager::setConnectHandler(std::function<void(const mqtt::connect_response&)> h) {
+    connectHandler = std::move(h);
+}
+
+//--> Hook to drop per-connection state
+void ConnectionManager::setConnectionLostHandler(std::function<void()> h) {
+    lostHandler = std::move(h);
+}
+
+//--> Start the thread
+void ConnectionManager::start() {
+    std::lock_guard<std::mutex> guard(lock);
+    if (running) return;
+    running = true;
+    worker = std::thread(&ConnectionManager::run, this);
+}
+
+//--> Stop the thread and disconnect
+void ConnectionManager::stop() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!running) return;
+        running = false;
+    }
+    wake.notify_all();
+    worker.join();
+    try {
+        if (client.is_connected()) client.disconnect()->wait_for(std::chrono::seconds(2));
+    } catch (const mqtt::exception&) { }
+}
+
+//--> Copy of the counters
+ConnectionMetrics ConnectionManager::metrics() {
+    std::lock_guard<std::mutex> guard(lock);
+    ConnectionMetrics m = stats;
+    m.state = currentState.load();
+    return m;
+}
+
+//--> Connect, wait for a lost connection, back off, repeat
+void ConnectionManager::run() {
+    unsigned failures = 0;
+    std::unique_lock<std::mutex> guard(lock);
+
+    while (running) {
+        //--> Cleared before the attempt, a loss reported while it runs must not be forgotten
+        currentState = ConnectionState::Connecting;
+        connectionLost = false;
+        guard.unlock();
+        bool ok = attempt();
+        guard.lock();
+
+        if (ok) {
+            failures = 0;
+            if (!connectionLost) currentState = ConnectionState::Connected;
+
+            //--> Sleep until paho reports the connection lost or we get stopped
+            wake.wait(guard, [this] { return !running || connectionLost; });
+            continue;
+        }
+
+        //--> Failed, wait with jittered exponential backoff
+        stats.failedAttempts++;
+        currentState = ConnectionState::WaitingToRetry;
+        wake.wait_for(guard, backoff(failures++), [this] { return !running; });
+    }
+}
+
+//--> Blocking connect on the manager thread, then resubscribe
+bool ConnectionManager::attempt() {
+    try {
+        mqtt::token_ptr tok = client.connect(connectOptions);
+        tok->wait();
+        mqtt::connect_response response = tok->get_connect_response();
+        if (connectHandler) connectHandler(response);
+
+        std::vector<std::pair<std::string, int>> topics;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            topics = subscriptions;
+            stats.connects++;
+            if (stats.lost) stats.reconnects++;
+            stats.sessionPresent = response.is_session_present();
+        }
+
+        //--> The broker may have dropped the session, subscribe again to be sure
+        for (const auto& sub : topics) client.subscribe(sub.first, sub.second)->wait();
+        return true;
+    } catch (const mqtt::exception&) {
+        //--> Connected but a subscribe failed: disconnect so the next attempt starts clean
+        try {
+            if (client.is_connected()) client.disconnect()->wait_for(std::chrono::seconds(2));
+        } catch (const mqtt::exception&) { }
+        return false;
+    }
+}
+
+//--> min(initial * multiplier^failures, max), randomised down by up to the jitter fraction
+std::chrono::milliseconds ConnectionManager::backoff(unsigned failures) {
+    static thread_local std::mt19937 random{std::random_device{}()};
+
+    double delay = reconnectOptions.initialDelay.count();
+    for (unsigned i = 0; i < failures && delay < reconnectOptions.maxDelay.count(); i++) delay *= reconnectOptions.multiplier;
+    delay = std::min(delay, static_cast<double>(reconnectOptions.maxDelay.count()));
+
+    std::uniform_real_distribution<double> spread(1.0 - reconnectOptions.jitter, 1.0);
+    return std::chrono::milliseconds(static_cast<int64_t>(delay * spread(random)));
+}
+
+//--> Paho: connected (also called after a paho side reconnect)
+void ConnectionManager::connected(const std::string& cause) {
+    if (handler) handler->connected(cause);
+}
+
+//--> Paho: connection lost, wake the manager thread
+void ConnectionManager::connection_lost(const std::string& cause) {
+    if (lostHandler) lostHandler();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stats.lost++;
+        connectionLost = true;
+        currentState = ConnectionState::WaitingToRetry;
+    }
+    wake.notify_all();
+    if (handler) handler->connection_lost(cause);
+}
+
+//--> Paho: forward messages
+void ConnectionManager::message_arrived(mqtt::const_message_ptr msg) {
+    if (handler) handler->message_arrived(msg);
+}
+
+//--> Paho: forward delivery notifications
+void ConnectionManager::delivery_complete(mqtt::delivery_token_ptr tok) {
+    if (handler) handler->delivery_complete(tok);
+}
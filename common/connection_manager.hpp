@@ -0,0 +1,119 @@
+/*!
+ * \file      connection_manager.hpp
+ * \brief     Keeps the mqtt connection up from its own thread
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * The manager thread connects, and after a lost connection reconnects with
+ * exponential backoff plus random jitter, so a fleet of devices does not hit a
+ * restarted broker at the same moment. The session is persistent (clean
+ * session off, fixed client id) so the broker keeps QoS1 state and
+ * subscriptions, and every subscription is sent again after each connect in
+ * case the broker lost the session anyway. With MQTT v5 options clean start is
+ * turned off instead, the session expiry interval is up to the caller. The sample loop never waits for
+ * any of this, it only reads state().
+ *
+ */
+
+#ifndef CONNECTION_MANAGER_HPP
+#define CONNECTION_MANAGER_HPP
+
+#include "connection_state.hpp"
+#include <mqtt/async_client.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//--> Backoff settings
+struct ReconnectOptions {
+    std::chrono::milliseconds initialDelay{500};
+    std::chrono::milliseconds maxDelay{60000};
+    double multiplier = 2.0;
+    double jitter = 0.5;                // delay is randomised between (1 - jitter) and 1 times the backoff
+};
+
+//--> Connection counters
+struct ConnectionMetrics {
+    ConnectionState state;
+    uint64_t connects;                  // successful connects, the first one included
+    uint64_t reconnects;                // successful connects after a lost connection
+    uint64_t failedAttempts;
+    uint64_t lost;                      // times the connection dropped
+    bool sessionPresent;                // broker still had our session on the last connect
+};
+
+//--> Connection manager thread for one client
+class ConnectionManager : public virtual mqtt::callback {
+
+//-> Public functions
+public:
+    //--> Constructor, the client callback is set to the manager
+    ConnectionManager(mqtt::async_client& client, mqtt::connect_options options, ReconnectOptions reconnect = {});
+
+    //--> Destructor, stops the thread
+    ~ConnectionManager();
+
+    //--> Subscribe now (when connected) and after every connect
+    void addSubscription(const std::string& topic, int qos);
+
+    //--> Forward incoming messages to this callback (may be nullptr)
+    void setMessageHandler(mqtt::callback* handler);
+
+    //--> Called on the manager thread after every connect, before resubscribing
+    void setConnectHandler(std::function<void(const mqtt::connect_response&)> handler);
+
+    //--> Called on the paho thread when the connection drops
+    void setConnectionLostHandler(std::function<void()> handler);
+
+    //--> Start and stop the manager thread
+    void start();
+    void stop();
+
+    //--> Current state and counters, never blocks on the network
+    ConnectionState state() const { return currentState.load(); }
+    ConnectionMetrics metrics();
+
+//-> Private functions and variables
+private:
+    mqtt::async_client& client;
+    mqtt::connect_options connectOptions;
+    ReconnectOptions reconnectOptions;
+    mqtt::callback* handler = nullptr;
+    std::function<void(const mqtt::connect_response&)> connectHandler;
+    std::function<void()> lostHandler;
+
+    std::thread worker;
+    std::mutex lock;
+    std::condition_variable wake;
+    bool running = false;
+    bool connectionLost = false;
+
+    std::atomic<ConnectionState> currentState{ConnectionState::Connecting};
+    std::vector<std::pair<std::string, int>> subscriptions;
+    ConnectionMetrics stats{};
+
+    //--> Thread body
+    void run();
+
+    //--> One connect attempt plus resubscribe, true when connected
+    bool attempt();
+
+    //--> Backoff delay for the given number of failed attempts
+    std::chrono::milliseconds backoff(unsigned failures);
+
+    //--> Paho callbacks
+    void connected(const std::string& cause) override;
+    void connection_lost(const std::string& cause) override;
+    void message_arrived(mqtt::const_message_ptr msg) override;
+    void delivery_complete(mqtt::delivery_token_ptr tok) override;
+};
+
+#endif //--> CONNECTION_MANAGER_HPP
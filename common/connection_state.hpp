@@ -0,0 +1,33 @@
+/*!
+ * \file      connection_state.hpp
+ * \brief     Connection state shared by the connection manager and the transports
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Kept apart from connection_manager.hpp so code that only needs the state,
+ * like the Transport interface and the loopback, builds without paho.
+ *
+ */
+
+#ifndef CONNECTION_STATE_HPP
+#define CONNECTION_STATE_HPP
+
+//--> Connection state as seen by the rest of the program
+enum class ConnectionState {
+    Connecting,
+    Connected,
+    WaitingToRetry
+};
+
+//--> Name of a state for logging and metrics
+inline const char* connectionStateName(ConnectionState state) {
+    switch (state) {
+        case ConnectionState::Connecting: return "connecting";
+        case ConnectionState::Connected: return "connected";
+        case ConnectionState::WaitingToRetry: return "waiting";
+    }
+    return "unknown";
+}
+
+#endif //--> CONNECTION_STATE_HPP
@@ -0,0 +1,67 @@
+/*!
+ * \file      crc32.hpp
+ * \brief     crc32 (IEEE) for the records in the files on disk
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Used by the spool and the storage files to find records torn by a power
+ * cut, and by the time-series reader on every record of a segment it
+ * indexes, so it has to keep up with reading the file. Table driven, eight
+ * bytes per step (slicing-by-8, the tables are built on first use), about
+ * four times the speed of one byte per step. Built for a CPU with the ARMv8
+ * CRC32 instructions (Pi 3/4/5 with -march=armv8-a+crc) it uses those.
+ *
+ */
+
+#ifndef CRC32_HPP
+#define CRC32_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#if defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+//--> crc32 of a block, pass the result of the previous call as crc to continue over more blocks
+inline uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    crc = ~crc;
+#if defined(__ARM_FEATURE_CRC32)
+    for (; length >= 8; data += 8, length -= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        crc = __crc32d(crc, word);
+    }
+    for (; length > 0; length--) crc = __crc32b(crc, *data++);
+#else
+    static const struct Table {
+        uint32_t entries[8][256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                entries[0][i] = c;
+            }
+            for (int slice = 1; slice < 8; slice++) {
+                for (uint32_t i = 0; i < 256; i++) {
+                    uint32_t c = entries[slice - 1][i];
+                    entries[slice][i] = entries[0][c & 0xFF] ^ (c >> 8);
+                }
+            }
+        }
+    } table;
+
+    const auto& t = table.entries;
+    for (; length >= 8; data += 8, length -= 8) {
+        uint32_t one = crc ^ (data[0] | data[1] << 8 | data[2] << 16 | static_cast<uint32_t>(data[3]) << 24);
+        uint32_t two = data[4] | data[5] << 8 | data[6] << 16 | static_cast<uint32_t>(data[7]) << 24;
+        crc = t[7][one & 0xFF] ^ t[6][(one >> 8) & 0xFF] ^ t[5][(one >> 16) & 0xFF] ^ t[4][one >> 24] ^
+              t[3][two & 0xFF] ^ t[2][(two >> 8) & 0xFF] ^ t[1][(two >> 16) & 0xFF] ^ t[0][two >> 24];
+    }
+    for (; length > 0; length--) crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+#endif
+    return ~crc;
+}
+
+#endif //--> CRC32_HPP
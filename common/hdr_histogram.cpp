@@ -0,0 +1,71 @@
+/*!
+ * \file      hdr_histogram.cpp
+ * \brief     Fixed-memory latency histogram with constant relative precision (HDR style)
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "hdr_histogram.hpp"
+#include <algorithm>
+#include <cmath>
+
+//--> Constructor, size the sub-buckets for the precision and the buckets for the range
+HdrHistogram::HdrHistogram(int64_t highestValue, int significantDigits) : highest(std::max<int64_t>(highestValue, 2)) {
+    significantDigits = std::clamp(significantDigits, 1, 5);
+
+    //--> Sub-buckets per bucket: smallest power of two that holds 2 * 10^digits
+    int64_t needed = 2 * static_cast<int64_t>(std::pow(10, significantDigits));
+    int subBucketBits = 1;
+    while ((int64_t{1} << subBucketBits) < needed) subBucketBits++;
+    subBucketHalfBits = subBucketBits - 1;
+    subBucketMask = (int64_t{1} << subBucketBits) - 1;
+
+    //--> Bucket b holds values up to 2^(subBucketBits + b) - 1
+    int buckets = 1;
+    while (buckets + subBucketBits < 63 && (int64_t{1} << (subBucketBits + buckets - 1)) <= highest) buckets++;
+    counts.assign(static_cast<size_t>(buckets + 1) << subBucketHalfBits, 0);
+}
+
+//--> Walk the counts until the wanted share of the values is passed
+int64_t HdrHistogram::percentile(double percent) const {
+    if (total == 0) return 0;
+    percent = std::clamp(percent, 0.0, 100.0);
+    uint64_t target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percent / 100.0 * total)));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); i++) {
+        seen += counts[i];
+        if (seen >= target) return std::min(highestInSlot(i), maximum);
+    }
+    return maximum;
+}
+
+//--> Largest value that lands in the same slot
+int64_t HdrHistogram::highestInSlot(size_t i) const {
+    size_t half = size_t{1} << subBucketHalfBits;
+    if (i < 2 * half) return static_cast<int64_t>(i);
+
+    int bucket = static_cast<int>(i >> subBucketHalfBits) - 1;
+    int64_t subBucket = static_cast<int64_t>(i - (static_cast<size_t>(bucket) << subBucketHalfBits));
+    return ((subBucket + 1) << bucket) - 1;
+}
+
+//--> Merge, the histograms must be made with the same range and precision
+void HdrHistogram::add(const HdrHistogram& other) {
+    if (other.counts.size() != counts.size() || other.subBucketHalfBits != subBucketHalfBits) return;
+    for (size_t i = 0; i < counts.size(); i++) counts[i] += other.counts[i];
+    total += other.total;
+    sum += other.sum;
+    minimum = std::min(minimum, other.minimum);
+    maximum = std::max(maximum, other.maximum);
+}
+
+//--> Clear all counts
+void HdrHistogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0;
+    minimum = INT64_MAX;
+    maximum = 0;
+}
@@ -0,0 +1,87 @@
+/*!
+ * \file      hdr_histogram.hpp
+ * \brief     Fixed-memory latency histogram with constant relative precision (HDR style)
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Values are counted in buckets that double in width: every power of two
+ * range is split in the same number of sub-buckets, enough for the requested
+ * number of significant digits. With 3 digits any value from 1 to the
+ * highest trackable value is stored within 0.1 %, in a few tens of KiB,
+ * and record() is a count-leading-zeros, a shift and an increment. Unlike a
+ * window of raw samples the memory does not grow with the number of
+ * samples, so p99.9 over millions of messages is as cheap as over a few.
+ *
+ * Not thread safe, use one histogram per thread and merge with add().
+ *
+ */
+
+#ifndef HDR_HISTOGRAM_HPP
+#define HDR_HISTOGRAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//--> Histogram of non-negative integer values (for example latencies in us)
+class HdrHistogram {
+
+//-> Public functions
+public:
+    //--> Constructor, values above highest are counted as highest
+    explicit HdrHistogram(int64_t highest = 60000000, int significantDigits = 3);
+
+    //--> Count one value, negative values count as 0
+    void record(int64_t value) {
+        if (value < 0) value = 0;
+        if (value > highest) value = highest;
+        counts[index(value)]++;
+        total++;
+        sum += value;
+        if (value < minimum) minimum = value;
+        if (value > maximum) maximum = value;
+    }
+
+    //--> Value below which the given percentage (0..100) of the values lies, within the precision
+    int64_t percentile(double percent) const;
+
+    //--> Number of recorded values
+    uint64_t count() const { return total; }
+
+    //--> Smallest and largest recorded value, exact (0 when empty)
+    int64_t min() const { return total ? minimum : 0; }
+    int64_t max() const { return total ? maximum : 0; }
+
+    //--> Average of the recorded values
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    //--> Add the counts of a histogram with the same layout
+    void add(const HdrHistogram& other);
+
+    //--> Forget all values
+    void reset();
+
+//-> Private functions and variables
+private:
+    int64_t highest;
+    int subBucketHalfBits;              // log2 of half the sub-buckets per bucket
+    int64_t subBucketMask;
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    int64_t sum = 0;
+    int64_t minimum = INT64_MAX;
+    int64_t maximum = 0;
+
+    //--> Position of a value in counts
+    size_t index(int64_t value) const {
+        int bucket = 63 - __builtin_clzll(static_cast<uint64_t>(value | subBucketMask)) - subBucketHalfBits;
+        int64_t subBucket = value >> bucket;
+        return (static_cast<size_t>(bucket) << subBucketHalfBits) + static_cast<size_t>(subBucket);
+    }
+
+    //--> Largest value that lands in the same slot as counts[i]
+    int64_t highestInSlot(size_t i) const;
+};
+
+#endif //--> HDR_HISTOGRAM_HPP
@@ -0,0 +1,162 @@
+/*!
+ * \file      inflight_publisher.cpp
+ * \brief     Non-blocking mqtt publisher with a bounded number of messages in flight
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "inflight_publisher.hpp"
+#include "clock.hpp"
+
+//--> Constructor, all slots start free
+InflightPublisher::InflightPublisher(mqtt::async_client& client, size_t window,
+                                     BackpressurePolicy policy, std::chrono::milliseconds blockTimeout)
+    : client(client), policy(policy), blockTimeout(blockTimeout), slots(window) {
+    for (size_t i = 0; i < window; i++) {
+        slots[i].index = i;
+        freeSlots.push_back(window - 1 - i);
+    }
+}
+
+//--> Offline or behind a backlog the message goes to the spool, otherwise straight out
+bool InflightPublisher::publish(mqtt::const_message_ptr msg) {
+    if (spool && (!client.is_connected() || !spool->empty())) return store(msg);
+    return send(msg, Route::Normal);
+}
+
+//--> Only offline the message goes to the spool, a backlog does not hold it up
+bool InflightPublisher::publishUrgent(mqtt::const_message_ptr msg) {
+    if (spool && !client.is_connected()) return store(msg);
+    return send(msg, Route::Urgent);
+}
+
+//--> Only while connected, the spool is never touched
+bool InflightPublisher::publishLive(mqtt::const_message_ptr msg) {
+    if (!client.is_connected()) return false;
+    return send(msg, Route::Live);
+}
+
+//--> Attach the spool
+void InflightPublisher::setSpool(Spool* s) {
+    spool = s;
+}
+
+//--> Attach the alias table
+void InflightPublisher::setTopicAliases(TopicAliases* a) {
+    aliases = a;
+}
+
+//--> Replay from the spool, stops when the window is full or the connection drops
+void InflightPublisher::drainSpool() {
+    if (!spool || !client.is_connected()) return;
+    spool->drain([this](const std::string& topic, std::string_view payload, int qos) {
+        auto msg = mqtt::make_message(topic, std::string(payload));
+        msg->set_qos(qos);
+        return client.is_connected() && !windowFull() && send(msg, Route::Replay);
+    });
+}
+
+//--> Spool a message that could not be published
+bool InflightPublisher::store(const mqtt::const_message_ptr& msg) {
+    if (!spool) return false;
+    return spool->append(msg->get_topic(), msg->get_payload_str(), msg->get_qos());
+}
+
+//--> No free slot right now
+bool InflightPublisher::windowFull() {
+    std::lock_guard<std::mutex> guard(lock);
+    return freeSlots.empty();
+}
+
+//--> Take a slot, hand the message to paho and return without waiting for the ACK
+bool InflightPublisher::send(mqtt::const_message_ptr msg, Route route) {
+    bool mayBlock = route == Route::Urgent || (route == Route::Normal && policy == BackpressurePolicy::Block);
+    Slot* slot;
+    {
+        std::unique_lock<std::mutex> guard(lock);
+        if (freeSlots.empty() && mayBlock) {
+            slotFreed.wait_for(guard, blockTimeout, [this] { return !freeSlots.empty(); });
+        }
+        if (freeSlots.empty()) {
+            //--> An urgent message is kept, behind the backlog is better than lost
+            if (route == Route::Urgent && spool) {
+                guard.unlock();
+                return store(msg);
+            }
+            stats.dropped++;
+            return false;
+        }
+
+        slot = &slots[freeSlots.back()];
+        freeSlots.pop_back();
+        slot->startNs = monotonicNs();
+        if (route != Route::Live) slot->msg = msg;
+
+        stats.inFlight++;
+        if (stats.inFlight > stats.maxInFlight) stats.maxInFlight = stats.inFlight;
+        stats.published++;
+    }
+
+    //--> Outside the lock, paho may call back on its own thread before this returns
+    try {
+        client.publish(aliases ? aliases->apply(msg) : msg, slot, *this);
+    } catch (const mqtt::exception&) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            slot->msg.reset();
+            freeSlots.push_back(slot->index);
+            stats.inFlight--;
+            stats.failed++;
+            slotFreed.notify_one();
+        }
+
+        //--> A replayed message is still in the spool: drain() stops and leaves it at the head
+        return (route == Route::Normal || route == Route::Urgent) && store(msg);
+    }
+    return true;
+}
+
+//--> Copy of the counters
+PublisherMetrics InflightPublisher::metrics() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
+
+//--> Broker ACKed the message
+void InflightPublisher::on_success(const mqtt::token& tok) {
+    release(tok, true);
+}
+
+//--> Delivery failed (connection lost, broker refused)
+void InflightPublisher::on_failure(const mqtt::token& tok) {
+    release(tok, false);
+}
+
+//--> Free the slot of a finished message and record its latency
+void InflightPublisher::release(const mqtt::token& tok, bool delivered) {
+    Slot* slot = static_cast<Slot*>(tok.get_user_context());
+    if (!slot) return;
+
+    int64_t latencyUs = (monotonicNs() - slot->startNs) / 1000;
+    mqtt::const_message_ptr msg;
+
+    std::unique_lock<std::mutex> guard(lock);
+    msg.swap(slot->msg);
+    freeSlots.push_back(slot->index);
+    stats.inFlight--;
+    if (delivered) {
+        stats.delivered++;
+        stats.lastLatencyUs = latencyUs;
+        if (latencyUs > stats.maxLatencyUs) stats.maxLatencyUs = latencyUs;
+        latencySumUs += latencyUs;
+        stats.avgLatencyUs = latencySumUs / static_cast<int64_t>(stats.delivered);
+    } else {
+        stats.failed++;
+    }
+    slotFreed.notify_one();
+    guard.unlock();
+
+    //--> Not delivered, keep it for replay
+    if (!delivered && msg) store(msg);
+}
@@ -0,0 +1,145 @@
+/*!
+ * \file      inflight_publisher.hpp
+ * \brief     Non-blocking mqtt publisher with a bounded number of messages in flight
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * publish() hands the message to paho and returns straight away, the broker
+ * ACK is tracked through the delivery token callback. At most `window`
+ * messages can wait for an ACK, when all slots are taken the backpressure
+ * policy decides: drop the new message or block for a limited time.
+ * Publish latency (publish call to ACK) and in-flight depth are kept as metrics.
+ *
+ * With a spool attached, messages are stored on disk instead of lost while the
+ * client is disconnected or when delivery fails. As long as the spool holds
+ * data new messages are queued behind it, and drainSpool() replays them in
+ * order at the spool drain rate. A replayed message that paho refuses stays
+ * at the head of the spool for the next drain. Only a message that was
+ * already in flight when its delivery failed is spooled again behind the
+ * others, so it arrives later than the messages after it; the seq and ts_us
+ * in the payload put it back in place.
+ *
+ * publishUrgent() is the path for alarms: while connected it goes out at
+ * once, even when the spool still holds a backlog, and waits for a slot up
+ * to the block timeout whatever the policy. Only while offline, when no
+ * slot frees up or when delivery fails does it go to the spool.
+ * publishLive() is for values that only matter now (metrics): sent while
+ * connected, never spooled, dropped when the window is full or delivery fails.
+ *
+ * With MQTT v5 topic aliases attached, every message is passed through them
+ * right before it goes to paho. The spool and the retry path keep the
+ * original message with its full topic.
+ *
+ */
+
+#ifndef INFLIGHT_PUBLISHER_HPP
+#define INFLIGHT_PUBLISHER_HPP
+
+#include "spool.hpp"
+#include "topic_aliases.hpp"
+#include <mqtt/async_client.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+//--> What to do with a new message when the window is full
+enum class BackpressurePolicy {
+    DropNewest,     // drop the new message, sampling never waits
+    Block           // wait up to the block timeout for a free slot, then drop
+};
+
+//--> Snapshot of the publisher counters
+struct PublisherMetrics {
+    size_t inFlight;            // messages waiting for an ACK right now
+    size_t maxInFlight;         // highest in-flight depth seen
+    uint64_t published;         // handed to paho
+    uint64_t delivered;         // ACKed by the broker
+    uint64_t failed;            // publish or delivery failed
+    uint64_t dropped;           // dropped by the backpressure policy
+    int64_t lastLatencyUs;      // publish to ACK of the last delivered message
+    int64_t avgLatencyUs;
+    int64_t maxLatencyUs;
+};
+
+//--> Publisher that tracks delivery instead of waiting for it
+class InflightPublisher : public virtual mqtt::iaction_listener {
+
+//-> Public functions
+public:
+    //--> Constructor
+    InflightPublisher(mqtt::async_client& client, size_t window,
+                      BackpressurePolicy policy = BackpressurePolicy::DropNewest,
+                      std::chrono::milliseconds blockTimeout = std::chrono::milliseconds(100));
+
+    //--> Start publishing, returns false when the message was dropped or paho refused it
+    bool publish(mqtt::const_message_ptr msg);
+
+    //--> Start publishing ahead of the spool backlog (alarms), spooled only when it cannot go out now
+    bool publishUrgent(mqtt::const_message_ptr msg);
+
+    //--> Publish past the spool and never into it (metrics), returns false offline or when it was dropped
+    bool publishLive(mqtt::const_message_ptr msg);
+
+    //--> Store messages in this spool while offline (nullptr = drop them)
+    void setSpool(Spool* spool);
+
+    //--> Shorten topics with MQTT v5 aliases (nullptr = send topics as they are)
+    void setTopicAliases(TopicAliases* aliases);
+
+    //--> Replay spooled messages while connected, call this every loop
+    void drainSpool();
+
+    //--> Current counters
+    PublisherMetrics metrics();
+
+//-> Private functions and variables
+private:
+    //--> Start time of one in-flight message, passed to paho as user context
+    struct Slot {
+        int64_t startNs;
+        size_t index;
+        mqtt::const_message_ptr msg;    // kept to spool it when delivery fails, empty for live messages
+    };
+
+    mqtt::async_client& client;
+    BackpressurePolicy policy;
+    std::chrono::milliseconds blockTimeout;
+
+    std::mutex lock;
+    std::condition_variable slotFreed;
+    std::vector<Slot> slots;
+    std::vector<size_t> freeSlots;
+    PublisherMetrics stats{};
+    int64_t latencySumUs = 0;
+    Spool* spool = nullptr;
+    TopicAliases* aliases = nullptr;
+
+    //--> Where a message comes from, decides how long it may wait for a slot and whether a refused one is spooled
+    enum class Route {
+        Normal,     // publish(), waits only under the Block policy
+        Urgent,     // publishUrgent(), always waits, spooled when no slot frees up
+        Replay,     // drainSpool(), never waits, a refused one stays in the spool
+        Live        // publishLive(), never waits and never spooled
+    };
+
+    //--> Publish into a free slot, a refused message is spooled unless it came from the spool or is live
+    bool send(mqtt::const_message_ptr msg, Route route);
+
+    //--> True when all slots are in flight
+    bool windowFull();
+
+    //--> Put a message in the spool, false when there is none or it is full
+    bool store(const mqtt::const_message_ptr& msg);
+
+    //--> Delivery token callbacks from the paho thread
+    void on_success(const mqtt::token& tok) override;
+    void on_failure(const mqtt::token& tok) override;
+
+    //--> Give a slot back and update the counters
+    void release(const mqtt::token& tok, bool delivered);
+};
+
+#endif //--> INFLIGHT_PUBLISHER_HPP
@@ -0,0 +1,159 @@
+/*!
+ * \file      json_reader.hpp
+ * \brief     Zero-copy reader for the flat JSON records the publishers send
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Counterpart of json_writer.hpp. The publishers send flat objects of
+ * numbers, one per message or batched as {"samples":[{...},{...}]}.
+ * next() walks the payload and stops at every object that holds no other
+ * object or array, so both shapes come out as the same records:
+ *
+ *   JsonReader reader(payload);
+ *   JsonRecord record;
+ *   while (reader.next(record)) { record.find("ts_us"); ... }
+ *
+ * Keys are string_views into the payload (escapes are not decoded, the
+ * writers never produce them) and numbers are read with std::from_chars,
+ * nothing is copied or allocated. String, true/false and null values are
+ * skipped. The payload has to outlive the records.
+ *
+ */
+
+#ifndef JSON_READER_HPP
+#define JSON_READER_HPP
+
+#include <charconv>
+#include <cstddef>
+#include <string_view>
+
+//--> Max number of fields kept of one record, more are counted but skipped
+const size_t JSON_MAX_FIELDS = 24;
+
+//--> One numeric field
+struct JsonNumber {
+    std::string_view key;
+    double value;
+};
+
+//--> One flat object of the payload
+struct JsonRecord {
+    size_t count = 0;                       // fields in fields[]
+    size_t skipped = 0;                     // non-numeric fields and fields past JSON_MAX_FIELDS
+    JsonNumber fields[JSON_MAX_FIELDS];
+
+    //--> Field by key, nullptr when it is not there
+    const JsonNumber* find(std::string_view key) const {
+        for (size_t i = 0; i < count; i++) if (fields[i].key == key) return &fields[i];
+        return nullptr;
+    }
+};
+
+//--> Walks the records of one payload
+class JsonReader {
+
+//-> Public functions
+public:
+    //--> Constructor, text has to outlive the reader and the records
+    explicit JsonReader(std::string_view text) : text(text) {}
+
+    //--> Next flat object, false at the end of the payload or on malformed input
+    bool next(JsonRecord& record) {
+        while (findObject()) {
+            size_t start = pos;
+            if (readObject(record)) return true;
+            if (broken) return false;
+            pos = start;                    // object holds an object or array, look inside it
+        }
+        return false;
+    }
+
+    //--> True when next() stopped on malformed input instead of at the end
+    bool failed() const { return broken; }
+
+//-> Private functions and variables
+private:
+    std::string_view text;
+    size_t pos = 0;
+    bool broken = false;
+
+    //--> Move past spaces, tabs and newlines
+    void skipSpace() {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\n' || text[pos] == '\r' || text[pos] == '\t')) pos++;
+    }
+
+    //--> Move past a string starting at pos (on the opening quote), false when it does not end
+    bool skipString() {
+        for (pos++; pos < text.size(); pos++) {
+            if (text[pos] == '\\') pos++;
+            else if (text[pos] == '"') { pos++; return true; }
+        }
+        broken = true;
+        return false;
+    }
+
+    //--> Move to the next '{' outside a string, just past it
+    bool findObject() {
+        while (pos < text.size()) {
+            char c = text[pos];
+            if (c == '{') { pos++; return true; }
+            if (c == '"') { if (!skipString()) return false; }
+            else pos++;
+        }
+        return false;
+    }
+
+    //--> Read the fields of the object whose '{' was just passed, false when it nests or is malformed
+    bool readObject(JsonRecord& record) {
+        record.count = 0;
+        record.skipped = 0;
+        skipSpace();
+        if (pos < text.size() && text[pos] == '}') { pos++; return true; }
+
+        while (pos < text.size()) {
+            //--> "key"
+            if (text[pos] != '"') break;
+            size_t keyStart = pos + 1;
+            if (!skipString()) return false;
+            std::string_view key = text.substr(keyStart, pos - keyStart - 1);
+            skipSpace();
+            if (pos >= text.size() || text[pos] != ':') break;
+            pos++;
+            skipSpace();
+            if (pos >= text.size()) break;
+
+            //--> value
+            char c = text[pos];
+            if (c == '{' || c == '[') return false;
+            if (c == '"') {
+                if (!skipString()) return false;
+                record.skipped++;
+            } else {
+                double value;
+                auto [end, error] = std::from_chars(text.data() + pos, text.data() + text.size(), value);
+                if (error == std::errc()) {
+                    pos = static_cast<size_t>(end - text.data());
+                    if (record.count < JSON_MAX_FIELDS) record.fields[record.count++] = {key, value};
+                    else record.skipped++;
+                } else {
+                    //--> true, false or null
+                    while (pos < text.size() && text[pos] >= 'a' && text[pos] <= 'z') pos++;
+                    record.skipped++;
+                }
+            }
+
+            //--> , or }
+            skipSpace();
+            if (pos >= text.size()) break;
+            if (text[pos] == '}') { pos++; return true; }
+            if (text[pos] != ',') break;
+            pos++;
+            skipSpace();
+        }
+        broken = true;
+        return false;
+    }
+};
+
+#endif //--> JSON_READER_HPP
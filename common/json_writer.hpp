@@ -0,0 +1,155 @@
+/*!
+ * \file      json_writer.hpp
+ * \brief     Allocation-free JSON records from a compile-time field list
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * The field list is a constexpr array of JsonField. From it the literal text
+ * between the values ({"key":  ,"key":  }) is built at compile time, at run
+ * time only the numbers are formatted with std::to_chars into a fixed buffer
+ * that is reused for every record. No locale, no heap.
+ *
+ * Usage:
+ *   inline constexpr JsonField SENSOR_FIELDS[] = { {"seq", 0}, {"temperature", 2} };
+ *   JsonWriter<256> writer;
+ *   std::string_view json = writer.record<SENSOR_FIELDS>(seq, temp);
+ *
+ */
+
+#ifndef JSON_WRITER_HPP
+#define JSON_WRITER_HPP
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <type_traits>
+
+//--> One field: key and decimals for floats (-1 = shortest text that reads back to the same float)
+struct JsonField {
+    const char* key;
+    int precision;
+};
+
+//--> Literal text of a field list, built at compile time
+template <const auto& Fields>
+struct JsonLayout {
+    static constexpr size_t count = std::size(Fields);
+
+    //--> Length of a C string in a constant expression
+    static constexpr size_t length(const char* s) {
+        size_t n = 0;
+        while (s[n]) n++;
+        return n;
+    }
+
+    //--> Total literal characters: {"key": or ,"key": per field and the closing }
+    static constexpr size_t textSize() {
+        size_t n = 1;
+        for (size_t i = 0; i < count; i++) n += length(Fields[i].key) + 4;
+        return n;
+    }
+
+    //--> Longest record when every value is an integer (20 characters holds any int64 or uint64), to size a JsonWriter
+    static constexpr size_t maxIntegerSize() { return textSize() + 20 * count; }
+
+    struct Text {
+        std::array<char, textSize()> chars{};
+        std::array<size_t, count + 1> offsets{};    // literal i runs from offsets[i] to offsets[i + 1]
+    };
+
+    //--> Prefix before every value, the last slice is the closing brace
+    static constexpr Text build() {
+        Text t{};
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) {
+            t.offsets[i] = n;
+            t.chars[n++] = i ? ',' : '{';
+            t.chars[n++] = '"';
+            for (const char* k = Fields[i].key; *k; k++) t.chars[n++] = *k;
+            t.chars[n++] = '"';
+            t.chars[n++] = ':';
+        }
+        t.offsets[count] = n;
+        t.chars[n] = '}';
+        return t;
+    }
+
+    static constexpr Text text = build();
+};
+
+//--> Writes records into one reusable buffer
+template <size_t Capacity>
+class JsonWriter {
+
+//-> Public functions
+public:
+    //--> Constructor, not copyable because the write position points into the own buffer
+    JsonWriter() = default;
+    JsonWriter(const JsonWriter&) = delete;
+    JsonWriter& operator=(const JsonWriter&) = delete;
+
+    //--> Format one record, the view stays valid until the next call (empty when it does not fit)
+    template <const auto& Fields, typename... Values>
+    std::string_view record(Values... values) {
+        using Layout = JsonLayout<Fields>;
+        static_assert(sizeof...(Values) == Layout::count, "one value per field");
+
+        pos = buf;
+        ok = true;
+        size_t i = 0;
+        (writeField<Fields>(i++, values), ...);
+        literal(Layout::text.chars.data() + Layout::text.offsets[Layout::count], 1);
+        return ok ? std::string_view(buf, pos - buf) : std::string_view();
+    }
+
+//-> Private functions and variables
+private:
+    char buf[Capacity];
+    char* pos = buf;
+    bool ok = true;
+
+    //--> Literal prefix of field i, then its value
+    template <const auto& Fields, typename T>
+    void writeField(size_t i, T value) {
+        using Layout = JsonLayout<Fields>;
+        literal(Layout::text.chars.data() + Layout::text.offsets[i], Layout::text.offsets[i + 1] - Layout::text.offsets[i]);
+        number(value, Fields[i].precision);
+    }
+
+    void literal(const char* text, size_t n) {
+        if (static_cast<size_t>(buf + Capacity - pos) < n) {
+            ok = false;
+            return;
+        }
+        for (size_t k = 0; k < n; k++) pos[k] = text[k];
+        pos += n;
+    }
+
+    //--> Integers
+    template <typename T>
+    std::enable_if_t<std::is_integral_v<T>> number(T value, int) {
+        auto res = std::to_chars(pos, buf + Capacity, value);
+        if (res.ec != std::errc()) ok = false;
+        else pos = res.ptr;
+    }
+
+    //--> Floats, JSON has no NaN or infinity so those become null
+    template <typename T>
+    std::enable_if_t<std::is_floating_point_v<T>> number(T value, int precision) {
+        if (!std::isfinite(value)) {
+            literal("null", 4);
+            return;
+        }
+        auto res = precision < 0 ? std::to_chars(pos, buf + Capacity, value)
+                                 : std::to_chars(pos, buf + Capacity, value, std::chars_format::fixed, precision);
+        if (res.ec != std::errc()) ok = false;
+        else pos = res.ptr;
+    }
+};
+
+#endif //--> JSON_WRITER_HPP
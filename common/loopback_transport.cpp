@@ -0,0 +1,129 @@
+/*!
+ * \file      loopback_transport.cpp
+ * \brief     In-process transport: a lock-free queue from the publishers to local subscribers
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "loopback_transport.hpp"
+#include <chrono>
+
+//--> Level by level, + is one level, # is the rest (and the level above it)
+bool topicMatches(std::string_view filter, std::string_view topic) {
+    while (true) {
+        size_t f = filter.find('/');
+        size_t t = topic.find('/');
+        std::string_view level = filter.substr(0, f);
+
+        if (level == "#") return true;
+        if (level != "+" && level != topic.substr(0, t)) return false;
+
+        //--> Both at their last level: match, only one of them: "a/#" still matches "a"
+        if (f == std::string_view::npos || t == std::string_view::npos) {
+            return f == t || (t == std::string_view::npos && filter.substr(f + 1) == "#");
+        }
+        filter.remove_prefix(f + 1);
+        topic.remove_prefix(t + 1);
+    }
+}
+
+//--> Constructor
+LoopbackTransport::LoopbackTransport(bool deliveryThread) : threaded(deliveryThread) {}
+
+//--> Destructor
+LoopbackTransport::~LoopbackTransport() {
+    stop();
+}
+
+//--> Application subscription, goes to the message handler
+void LoopbackTransport::subscribe(const std::string& filter, int /*qos*/) {
+    subscriptions.push_back(Subscription{filter, nullptr});
+}
+
+//--> Set the application handler
+void LoopbackTransport::setMessageHandler(MessageHandler handler) {
+    applicationHandler = std::move(handler);
+}
+
+//--> Other subscriber in this process
+void LoopbackTransport::attach(const std::string& filter, MessageHandler handler) {
+    subscriptions.push_back(Subscription{filter, std::move(handler)});
+}
+
+//--> Start the delivery thread
+void LoopbackTransport::start() {
+    if (!threaded || running.exchange(true)) return;
+    worker = std::thread(&LoopbackTransport::run, this);
+}
+
+//--> Stop after the messages already queued are delivered
+void LoopbackTransport::stop() {
+    if (!running.exchange(false)) return;
+    if (worker.joinable()) worker.join();
+}
+
+//--> Queue the message, a full queue is waited out while the delivery thread runs (like a broker that is slow to ack)
+bool LoopbackTransport::publish(const std::string& topic, std::string payload, int /*qos*/) {
+    Message message{topic, std::move(payload)};
+    while (!queue.push(std::move(message))) {
+        if (!running.load(std::memory_order_relaxed)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        std::this_thread::yield();
+    }
+    published.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+//--> Deliver on this thread
+size_t LoopbackTransport::poll(size_t max) {
+    if (threaded) return 0;
+    Message message;
+    size_t count = 0;
+    while (count < max && queue.pop(message)) {
+        deliver(message);
+        count++;
+    }
+    return count;
+}
+
+//--> Every matching subscription gets the message once
+void LoopbackTransport::deliver(const Message& message) {
+    uint64_t calls = 0;
+    for (const Subscription& s : subscriptions) {
+        if (!topicMatches(s.filter, message.topic)) continue;
+        const MessageHandler& handler = s.handler ? s.handler : applicationHandler;
+        if (!handler) continue;
+        handler(message.topic, message.payload);
+        calls++;
+    }
+    if (calls) delivered.fetch_add(calls, std::memory_order_relaxed);
+    else unmatched.fetch_add(1, std::memory_order_relaxed);
+}
+
+//--> Spin a little when idle, then sleep so an idle loopback does not burn a core
+void LoopbackTransport::run() {
+    Message message;
+    unsigned idle = 0;
+    while (true) {
+        if (queue.pop(message)) {
+            deliver(message);
+            idle = 0;
+            continue;
+        }
+        //--> Messages published right before stop() are still delivered
+        if (!running.load()) {
+            while (queue.pop(message)) deliver(message);
+            break;
+        }
+        if (++idle < 64) std::this_thread::yield();
+        else std::this_thread::sleep_for(std::chrono::microseconds(50));
+    }
+}
+
+//--> Copy of the counters
+LoopbackMetrics LoopbackTransport::metrics() const {
+    return LoopbackMetrics{published.load(), dropped.load(), delivered.load(), unmatched.load(), queue.size()};
+}
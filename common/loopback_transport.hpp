@@ -0,0 +1,112 @@
+/*!
+ * \file      loopback_transport.hpp
+ * \brief     In-process transport: a lock-free queue from the publishers to local subscribers
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * publish() moves the message into an MpscQueue (common/mpsc_queue.hpp) and
+ * returns, when the queue is full it waits for room as long as the delivery
+ * thread runs (without it, or after stop(), the message is dropped). A single
+ * delivery thread takes messages out in order and calls
+ * every subscription whose filter matches the topic (+ and # like MQTT).
+ * The application's own subscriptions (subscribe() + setMessageHandler())
+ * and extra in-process subscribers (attach()) share the same queue, so a
+ * test can play the instructor panel and the trainee monitor around an
+ * unchanged program. Without a delivery thread the caller drives delivery
+ * with poll(), for benchmarks that want everything on one core.
+ *
+ * The state is always Connected and nothing is retained or persisted.
+ *
+ */
+
+#ifndef LOOPBACK_TRANSPORT_HPP
+#define LOOPBACK_TRANSPORT_HPP
+
+#include "transport.hpp"
+#include "mpsc_queue.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+//--> Loopback counters
+struct LoopbackMetrics {
+    uint64_t published;     // taken by publish()
+    uint64_t dropped;       // queue full and nobody delivering
+    uint64_t delivered;     // handler calls
+    uint64_t unmatched;     // messages no subscription wanted
+    size_t depth;           // waiting now
+};
+
+//--> True when an MQTT topic filter matches a topic
+bool topicMatches(std::string_view filter, std::string_view topic);
+
+//--> Transport to subscribers in this process
+class LoopbackTransport : public Transport {
+
+//-> Public functions
+public:
+    static constexpr size_t QUEUE_SIZE = 4096;
+
+    //--> Constructor, without a delivery thread messages only move on poll()
+    explicit LoopbackTransport(bool deliveryThread = true);
+
+    //--> Destructor, stops the delivery thread
+    ~LoopbackTransport() override;
+
+    LoopbackTransport(const LoopbackTransport&) = delete;
+    LoopbackTransport& operator=(const LoopbackTransport&) = delete;
+
+    void subscribe(const std::string& filter, int qos) override;
+    void setMessageHandler(MessageHandler handler) override;
+    void start() override;
+    void stop() override;
+    ConnectionState state() const override { return ConnectionState::Connected; }
+    bool publish(const std::string& topic, std::string payload, int qos) override;
+
+    //--> Extra in-process subscriber with its own handler, call before start()
+    void attach(const std::string& filter, MessageHandler handler);
+
+    //--> Deliver up to max waiting messages on the calling thread (only without a delivery thread), returns how many
+    size_t poll(size_t max = SIZE_MAX);
+
+    //--> Current counters
+    LoopbackMetrics metrics() const;
+
+//-> Private functions and variables
+private:
+    struct Message {
+        std::string topic;
+        std::string payload;
+    };
+
+    struct Subscription {
+        std::string filter;
+        MessageHandler handler;             // empty for the application's own subscriptions
+    };
+
+    bool threaded;
+    MpscQueue<Message, QUEUE_SIZE> queue;
+    std::vector<Subscription> subscriptions;
+    MessageHandler applicationHandler;
+
+    std::thread worker;
+    std::atomic<bool> running{false};
+
+    std::atomic<uint64_t> published{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> delivered{0};
+    std::atomic<uint64_t> unmatched{0};
+
+    //--> Hand one message to every matching subscription
+    void deliver(const Message& message);
+
+    //--> Delivery thread body
+    void run();
+};
+
+#endif //--> LOOPBACK_TRANSPORT_HPP
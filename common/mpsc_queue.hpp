@@ -0,0 +1,102 @@
+/*!
+ * \file      mpsc_queue.hpp
+ * \brief     Bounded lock-free queue, many producers and one consumer
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Ring of Capacity cells, every cell has a sequence number that tells whose
+ * turn it is: producers claim a position with one compare-and-swap on the
+ * head and publish the value by bumping the sequence of the cell, the single
+ * consumer reads in order without any atomic read-modify-write. push() never
+ * blocks or allocates, when the ring is full it returns false.
+ *
+ */
+
+#ifndef MPSC_QUEUE_HPP
+#define MPSC_QUEUE_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+//--> Bounded multi-producer single-consumer queue
+template <typename T, size_t Capacity>
+class MpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+//-> Public functions
+public:
+    //--> Constructor, every cell is free for the lap starting at its index
+    MpscQueue() {
+        for (size_t i = 0; i < Capacity; i++) cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    //--> Add a value from any thread, false when the queue is full
+    bool push(const T& value) {
+        T copy = value;
+        return push(std::move(copy));
+    }
+
+    //--> Same, the value is moved into the queue (only when it was added)
+    bool push(T&& value) {
+        size_t pos = head.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells[pos & (Capacity - 1)];
+            size_t seq = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                //--> Cell is free for this position, claim it
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                //--> Consumer has not read this cell from the previous lap yet
+                return false;
+            } else {
+                //--> Another producer took it, try the new head
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //--> Take the oldest value, consumer thread only, false when empty
+    bool pop(T& value) {
+        size_t pos = tail.load(std::memory_order_relaxed);
+        Cell& cell = cells[pos & (Capacity - 1)];
+        if (cell.sequence.load(std::memory_order_acquire) != pos + 1) return false;
+
+        value = std::move(cell.value);
+        cell.sequence.store(pos + Capacity, std::memory_order_release);
+        tail.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    //--> Values waiting, exact on the consumer thread when no push is running, an estimate on other threads
+    size_t size() const {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t h = head.load(std::memory_order_relaxed);
+        return h > t ? h - t : 0;
+    }
+
+//-> Private functions and variables
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    //--> Head and tail on their own cache lines, producers and the consumer do not fight over them
+    alignas(64) std::array<Cell, Capacity> cells;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};       // written by the consumer only, atomic so size() can be read anywhere
+};
+
+#endif //--> MPSC_QUEUE_HPP
@@ -0,0 +1,54 @@
+/*!
+ * \file      paho_transport.cpp
+ * \brief     Transport over a paho mqtt client, kept connected by the ConnectionManager
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "paho_transport.hpp"
+#include <iostream>
+
+//--> Constructor, messages reach us through the connection manager
+PahoTransport::PahoTransport(mqtt::async_client& c, mqtt::connect_options options, ReconnectOptions reconnect,
+                             size_t window, BackpressurePolicy policy)
+    : connection(c, std::move(options), reconnect), publisher(c, window, policy) {
+    connection.setMessageHandler(this);
+}
+
+//--> Subscribed on every connect
+void PahoTransport::subscribe(const std::string& filter, int qos) {
+    connection.addSubscription(filter, qos);
+}
+
+//--> Set the application handler
+void PahoTransport::setMessageHandler(MessageHandler h) {
+    handler = std::move(h);
+}
+
+//--> Connect and keep connecting in the background
+void PahoTransport::start() {
+    connection.start();
+}
+
+//--> Stop reconnecting and disconnect
+void PahoTransport::stop() {
+    connection.stop();
+}
+
+//--> Hand one payload to paho, the ack is tracked by the publisher
+bool PahoTransport::publish(const std::string& topic, std::string payload, int qos) {
+    auto msg = mqtt::make_message(topic, std::move(payload));
+    msg->set_qos(qos);
+    return publisher.publish(msg);
+}
+
+//--> Reconnecting is the connection manager's job, only tell the user
+void PahoTransport::connection_lost(const std::string& cause) {
+    std::cerr << "mqtt connection lost, reconnecting: " << cause << std::endl;
+}
+
+//--> Hand the message to the application
+void PahoTransport::message_arrived(mqtt::const_message_ptr msg) {
+    if (msg && handler) handler(msg->get_topic(), msg->get_payload_str());
+}
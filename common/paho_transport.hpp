@@ -0,0 +1,58 @@
+/*!
+ * \file      paho_transport.hpp
+ * \brief     Transport over a paho mqtt client, kept connected by the ConnectionManager
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * publish() goes through an InflightPublisher: the message is handed to paho
+ * and the PUBACK is tracked in the background, so the caller never waits on
+ * the broker. At most `window` messages wait for their ACK. When all of them
+ * are taken the policy decides: DropNewest returns false at once, Block waits
+ * up to 100 ms for a slot (for runs that should go as fast as the broker
+ * takes it). Nothing is spooled, publish() only makes sense while Connected.
+ *
+ */
+
+#ifndef PAHO_TRANSPORT_HPP
+#define PAHO_TRANSPORT_HPP
+
+#include "transport.hpp"
+#include "connection_manager.hpp"
+#include "inflight_publisher.hpp"
+#include <mqtt/async_client.h>
+
+//--> Transport to a real broker
+class PahoTransport : public Transport, private virtual mqtt::callback {
+
+//-> Public functions
+public:
+    //--> Constructor, the client gets the connection manager as its callback
+    PahoTransport(mqtt::async_client& client, mqtt::connect_options options, ReconnectOptions reconnect = {},
+                  size_t window = 64, BackpressurePolicy policy = BackpressurePolicy::DropNewest);
+
+    void subscribe(const std::string& filter, int qos) override;
+    void setMessageHandler(MessageHandler handler) override;
+    void start() override;
+    void stop() override;
+    ConnectionState state() const override { return connection.state(); }
+    bool publish(const std::string& topic, std::string payload, int qos) override;
+
+    //--> Reconnect counters of the connection manager
+    ConnectionMetrics metrics() { return connection.metrics(); }
+
+    //--> In-flight, delivered and dropped counters of the publisher
+    PublisherMetrics publisherMetrics() { return publisher.metrics(); }
+
+//-> Private functions and variables
+private:
+    ConnectionManager connection;
+    InflightPublisher publisher;
+    MessageHandler handler;
+
+    //--> Paho callbacks, forwarded by the connection manager
+    void connection_lost(const std::string& cause) override;
+    void message_arrived(mqtt::const_message_ptr msg) override;
+};
+
+#endif //--> PAHO_TRANSPORT_HPP
@@ -0,0 +1,136 @@
+/*!
+ * \file      report_filter.cpp
+ * \brief     Report-by-exception filter for telemetry records
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "report_filter.hpp"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//--> Mode from the command line
+ReportMode parseReportMode(const std::string& text) {
+    if (text == "deadband") return ReportMode::Deadband;
+    if (text == "swinging-door") return ReportMode::SwingingDoor;
+    return ReportMode::All;
+}
+
+//--> Constructor
+ReportFilter::ReportFilter(std::vector<ChannelDeadband> channels, ReportMode mode, std::chrono::milliseconds heartbeat)
+    : channels(std::move(channels)), mode(mode),
+      heartbeatUs(std::chrono::duration_cast<std::chrono::microseconds>(heartbeat).count()) {
+    if (this->channels.size() > REPORT_MAX_CHANNELS) this->channels.resize(REPORT_MAX_CHANNELS);
+    doors.resize(this->channels.size());
+}
+
+//--> max(absolute, relative * |value|)
+float ReportFilter::width(size_t i, float value) const {
+    return std::max(channels[i].absolute, channels[i].relative * std::fabs(value));
+}
+
+//--> Deadband test against the last reported sample, a value turning NaN or back also counts
+bool ReportFilter::changed(const float* values) const {
+    for (size_t i = 0; i < channels.size(); i++) {
+        float last = archived.values[i];
+        if (std::isnan(values[i]) != std::isnan(last)) return true;
+        if (std::fabs(values[i] - last) > width(i, last)) return true;
+    }
+    return false;
+}
+
+//--> Fully open doors
+void ReportFilter::resetDoors() {
+    for (Door& door : doors) {
+        door.upper = -std::numeric_limits<double>::infinity();
+        door.lower = std::numeric_limits<double>::infinity();
+    }
+}
+
+//--> The upper door pivots at archived + width and only turns up, the lower one at archived - width and only turns down.
+//--> The line to the sample itself must also fit between them, otherwise reporting it would break the deadband for earlier samples
+bool ReportFilter::narrowDoors(const ReportPoint& point) {
+    double dt = (point.timestampUs - archived.timestampUs) / 1e6;
+    if (dt <= 0.0) return !changed(point.values);
+
+    bool open = true;
+    for (size_t i = 0; i < channels.size(); i++) {
+        float last = archived.values[i];
+        if (std::isnan(point.values[i]) || std::isnan(last)) {
+            if (std::isnan(point.values[i]) != std::isnan(last)) open = false;
+            continue;
+        }
+        double w = width(i, last);
+        doors[i].upper = std::max(doors[i].upper, (point.values[i] - last - w) / dt);
+        doors[i].lower = std::min(doors[i].lower, (point.values[i] - last + w) / dt);
+        double slope = (point.values[i] - last) / dt;
+        if (slope < doors[i].upper || slope > doors[i].lower) open = false;
+    }
+    return open;
+}
+
+//--> Hand a sample out for publishing
+size_t ReportFilter::report(const ReportPoint& point, ReportPoint* out, size_t n) {
+    out[n] = point;
+    archived = point;
+    stats.reported++;
+    return n + 1;
+}
+
+//--> Decide what to publish for this sample
+size_t ReportFilter::offer(uint64_t sequence, int64_t timestampUs, const float* values, ReportPoint out[2]) {
+    ReportPoint point;
+    point.sequence = sequence;
+    point.timestampUs = timestampUs;
+    std::copy(values, values + channels.size(), point.values);
+    stats.offered++;
+
+    //--> First sample and unfiltered mode always go out
+    if (!started || mode == ReportMode::All) {
+        started = true;
+        resetDoors();
+        return report(point, out, 0);
+    }
+
+    bool heartbeat = timestampUs - archived.timestampUs >= heartbeatUs;
+
+    if (mode == ReportMode::Deadband) {
+        if (changed(values)) return report(point, out, 0);
+        if (heartbeat) {
+            stats.heartbeats++;
+            return report(point, out, 0);
+        }
+        return 0;
+    }
+
+    //--> Swinging door still open, keep the sample until we know whether it is needed
+    if (narrowDoors(point)) {
+        if (heartbeat) {
+            stats.heartbeats++;
+            heldPending = false;
+            resetDoors();
+            return report(point, out, 0);
+        }
+        held = point;
+        heldPending = true;
+        return 0;
+    }
+
+    //--> Door closed, the previous sample is the end of the straight segment
+    size_t n = 0;
+    if (heldPending) n = report(held, out, n);
+    heldPending = false;
+    resetDoors();
+
+    //--> Start the next segment there, a jump can close it straight away
+    if (!narrowDoors(point)) {
+        n = report(point, out, n);
+        resetDoors();
+        return n;
+    }
+    held = point;
+    heldPending = true;
+    return n;
+}
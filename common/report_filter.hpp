@@ -0,0 +1,117 @@
+/*!
+ * \file      report_filter.hpp
+ * \brief     Report-by-exception filter for telemetry records
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Decides which samples are worth a message. Every channel (one value of the
+ * record) has a deadband: a change is significant when it is larger than
+ * max(absolute, relative * |last reported value|). A record is reported as a
+ * whole when any channel changed significantly, and at least once per
+ * heartbeat interval so consumers can tell a stable site from a dead one.
+ *
+ * Swinging-door mode keeps the shape of slow ramps with even fewer points:
+ * it reports a sample only when no straight line from the last reported
+ * sample stays within the deadband of every sample since. The point reported
+ * is then the previous sample, so consumers can interpolate linearly between
+ * reported points and stay within the deadband.
+ *
+ * Sequence numbers keep counting acquired samples, gaps on a filtered topic
+ * are suppressed samples, not lost ones.
+ *
+ */
+
+#ifndef REPORT_FILTER_HPP
+#define REPORT_FILTER_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//--> Max number of values in one record
+const size_t REPORT_MAX_CHANNELS = 16;
+
+//--> How samples are filtered
+enum class ReportMode {
+    All,                // every sample, no filtering
+    Deadband,           // on change beyond the deadband, plus heartbeat
+    SwingingDoor        // swinging-door compression with the deadband as door width, plus heartbeat
+};
+
+//--> Parse "all", "deadband" or "swinging-door", anything else is all
+ReportMode parseReportMode(const std::string& text);
+
+//--> Deadband of one channel, the larger of the two applies
+struct ChannelDeadband {
+    float absolute = 0.0f;      // in the unit of the channel
+    float relative = 0.0f;      // fraction of the last reported value, 0.01 = 1 %
+};
+
+//--> One sample as passed in and reported
+struct ReportPoint {
+    uint64_t sequence;
+    int64_t timestampUs;
+    float values[REPORT_MAX_CHANNELS];
+};
+
+//--> Filter counters
+struct ReportMetrics {
+    uint64_t offered;           // samples passed in
+    uint64_t reported;          // samples handed back for publishing
+    uint64_t heartbeats;        // of those, reported only because of the heartbeat
+};
+
+//--> Report-by-exception filter for records with a fixed channel layout
+class ReportFilter {
+
+//-> Public functions
+public:
+    //--> Constructor, one deadband per channel
+    ReportFilter(std::vector<ChannelDeadband> channels, ReportMode mode,
+                 std::chrono::milliseconds heartbeat = std::chrono::seconds(60));
+
+    //--> Offer one sample, writes the points to publish (0, 1 or 2) to out and returns how many
+    size_t offer(uint64_t sequence, int64_t timestampUs, const float* values, ReportPoint out[2]);
+
+    //--> Current counters
+    ReportMetrics metrics() const { return stats; }
+
+//-> Private functions and variables
+private:
+    //--> Swinging door of one channel, slopes in unit per second from the archived point
+    struct Door {
+        double upper;
+        double lower;
+    };
+
+    std::vector<ChannelDeadband> channels;
+    ReportMode mode;
+    int64_t heartbeatUs;
+
+    bool started = false;
+    ReportPoint archived{};         // last reported sample
+    ReportPoint held{};             // last offered sample, swinging door only
+    bool heldPending = false;       // held is newer than archived
+    std::vector<Door> doors;
+    ReportMetrics stats{};
+
+    //--> Deadband of channel i around value
+    float width(size_t i, float value) const;
+
+    //--> Any channel of values outside the deadband around archived
+    bool changed(const float* values) const;
+
+    //--> Open all doors again, starting at the archived point
+    void resetDoors();
+
+    //--> Narrow the doors with a new sample, false when one of them closed
+    bool narrowDoors(const ReportPoint& point);
+
+    //--> Copy a sample into out, make it the archived point and count it
+    size_t report(const ReportPoint& point, ReportPoint* out, size_t n);
+};
+
+#endif //--> REPORT_FILTER_HPP
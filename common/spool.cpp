@@ -0,0 +1,241 @@
+/*!
+ * \file      spool.cpp
+ * \brief     Disk backed store-and-forward queue for broker outages
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "spool.hpp"
+#include "clock.hpp"
+#include "crc32.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//--> Segment layout
+#define SPOOL_MAGIC         "SPOOLSEG"
+#define SPOOL_HEADER_SIZE   64
+#define SPOOL_READ_OFFSET   8           // u64 read offset in the header
+#define SPOOL_RECORD_HEAD   11          // length, crc, qos, topic length
+
+//--> Little-endian helpers
+static void putU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+static void putU64(uint8_t* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+static uint32_t getU32(const uint8_t* p) { uint32_t v = 0; for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i); return v; }
+static uint64_t getU64(const uint8_t* p) { uint64_t v = 0; for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i); return v; }
+
+//--> Constructor, reopen what a previous run left behind
+Spool::Spool(const SpoolOptions& opts) : options(opts) {
+    if (options.segmentSize < SPOOL_HEADER_SIZE + 1024) throw std::runtime_error("spool segment size too small");
+    mkdir(options.directory.c_str(), 0755);
+
+    //--> Find existing segments
+    std::vector<uint64_t> numbers;
+    DIR* dir = opendir(options.directory.c_str());
+    if (!dir) throw std::runtime_error("cannot open spool directory: " + options.directory);
+    while (dirent* entry = readdir(dir)) {
+        unsigned long long number;
+        if (std::sscanf(entry->d_name, "spool-%llu.seg", &number) == 1) numbers.push_back(number);
+    }
+    closedir(dir);
+    std::sort(numbers.begin(), numbers.end());
+
+    for (uint64_t number : numbers) {
+        Segment segment = openSegment(number, false);
+        scanSegment(segment);
+        stats.queued += segment.records;
+        segments.push_back(segment);
+        nextNumber = number + 1;
+    }
+    stats.segments = segments.size();
+    lastDrainNs = monotonicNs();
+}
+
+//--> Destructor
+Spool::~Spool() {
+    for (Segment& segment : segments) closeSegment(segment, false);
+}
+
+//--> Path of segment n
+std::string Spool::segmentPath(uint64_t number) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "spool-%06llu.seg", static_cast<unsigned long long>(number));
+    return options.directory + "/" + name;
+}
+
+//--> Open (or create) and map one segment file
+Spool::Segment Spool::openSegment(uint64_t number, bool create) {
+    std::string path = segmentPath(number);
+    int fd = open(path.c_str(), O_RDWR | (create ? O_CREAT | O_TRUNC : 0), 0644);
+    if (fd < 0) throw std::runtime_error("cannot open spool segment: " + path);
+    //--> New files, and files cut short by a crash, get the full size so the mapping never runs past the end
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (static_cast<size_t>(info.st_size) != options.segmentSize && ftruncate(fd, options.segmentSize) != 0)) {
+        close(fd);
+        throw std::runtime_error("cannot size spool segment: " + path);
+    }
+
+    void* map = mmap(nullptr, options.segmentSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("cannot map spool segment: " + path);
+    }
+
+    Segment segment{number, fd, static_cast<uint8_t*>(map), SPOOL_HEADER_SIZE, SPOOL_HEADER_SIZE, 0};
+    if (create) {
+        std::memcpy(segment.base, SPOOL_MAGIC, 8);
+        putU64(segment.base + SPOOL_READ_OFFSET, SPOOL_HEADER_SIZE);
+    }
+    return segment;
+}
+
+//--> Unmap, and delete the file when it is fully replayed
+void Spool::closeSegment(Segment& segment, bool remove) {
+    msync(segment.base, options.segmentSize, MS_SYNC);
+    munmap(segment.base, options.segmentSize);
+    close(segment.fd);
+    if (remove) unlink(segmentPath(segment.number).c_str());
+}
+
+//--> Walk the records from the read offset, the first invalid one is the end
+void Spool::scanSegment(Segment& segment) {
+    //--> Not a spool segment, never append to it and delete it on the next drain
+    if (std::memcmp(segment.base, SPOOL_MAGIC, 8) != 0) {
+        segment.writeOffset = segment.readOffset = options.segmentSize;
+        return;
+    }
+
+    size_t offset = getU64(segment.base + SPOOL_READ_OFFSET);
+    if (offset < SPOOL_HEADER_SIZE || offset > options.segmentSize) offset = SPOOL_HEADER_SIZE;
+    segment.readOffset = offset;
+
+    while (offset + SPOOL_RECORD_HEAD <= options.segmentSize) {
+        uint32_t length = getU32(segment.base + offset);
+        if (length < 3 || offset + 8 + length > options.segmentSize) break;
+        if (crc32(segment.base + offset + 8, length) != getU32(segment.base + offset + 4)) break;
+        offset += 8 + length;
+        segment.records++;
+    }
+    segment.writeOffset = offset;
+}
+
+//--> Persist how far the segment has been replayed
+void Spool::storeReadOffset(Segment& segment) {
+    putU64(segment.base + SPOOL_READ_OFFSET, segment.readOffset);
+}
+
+//--> Free room by removing the oldest segment
+void Spool::dropOldest() {
+    Segment& oldest = segments.front();
+    stats.dropped += oldest.records;
+    stats.queued -= oldest.records;
+    closeSegment(oldest, true);
+    segments.pop_front();
+}
+
+//--> Append a record to the newest segment, start a new one when it is full
+bool Spool::append(const std::string& topic, std::string_view payload, int qos) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    size_t length = 3 + topic.size() + payload.size();
+    size_t recordSize = 8 + length;
+    if (recordSize + SPOOL_HEADER_SIZE > options.segmentSize || topic.size() > 0xFFFF) {
+        stats.dropped++;
+        return false;
+    }
+
+    if (segments.empty() || segments.back().writeOffset + recordSize > options.segmentSize) {
+        if (segments.size() >= options.maxSegments) {
+            if (options.dropPolicy == SpoolDropPolicy::DropNewest) {
+                stats.dropped++;
+                return false;
+            }
+            dropOldest();
+        }
+        segments.push_back(openSegment(nextNumber++, true));
+    }
+
+    Segment& segment = segments.back();
+    uint8_t* p = segment.base + segment.writeOffset;
+    p[8] = static_cast<uint8_t>(qos);
+    p[9] = static_cast<uint8_t>(topic.size());
+    p[10] = static_cast<uint8_t>(topic.size() >> 8);
+    std::memcpy(p + SPOOL_RECORD_HEAD, topic.data(), topic.size());
+    std::memcpy(p + SPOOL_RECORD_HEAD + topic.size(), payload.data(), payload.size());
+    putU32(p + 4, crc32(p + 8, length));
+    putU32(p, static_cast<uint32_t>(length));
+
+    //--> Let the kernel write the pages back, without waiting for the SD card
+    static const uintptr_t pageMask = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE)) - 1;
+    uintptr_t start = reinterpret_cast<uintptr_t>(p) & ~pageMask;
+    msync(reinterpret_cast<void*>(start), reinterpret_cast<uintptr_t>(p) + recordSize - start, MS_ASYNC);
+
+    segment.writeOffset += recordSize;
+    segment.records++;
+    stats.queued++;
+    stats.spooled++;
+    stats.segments = segments.size();
+    return true;
+}
+
+//--> Nothing left to replay
+bool Spool::empty() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats.queued == 0;
+}
+
+//--> Token bucket limited replay in order
+size_t Spool::drain(const SendFunction& send) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    int64_t now = monotonicNs();
+    tokens = std::min(tokens + options.drainRate * (now - lastDrainNs) / 1e9, static_cast<double>(options.drainBurst));
+    lastDrainNs = now;
+
+    size_t sent = 0;
+    while (tokens >= 1.0 && !segments.empty()) {
+        Segment& segment = segments.front();
+
+        //--> Fully replayed, remove unless it is still being written
+        if (segment.readOffset >= segment.writeOffset) {
+            if (segments.size() == 1) break;
+            closeSegment(segment, true);
+            segments.pop_front();
+            stats.segments = segments.size();
+            continue;
+        }
+
+        const uint8_t* p = segment.base + segment.readOffset;
+        uint32_t length = getU32(p);
+        int qos = p[8];
+        size_t topicLength = p[9] | (p[10] << 8);
+        std::string topic(reinterpret_cast<const char*>(p + SPOOL_RECORD_HEAD), topicLength);
+        std::string_view payload(reinterpret_cast<const char*>(p + SPOOL_RECORD_HEAD + topicLength), length - 3 - topicLength);
+
+        if (!send(topic, payload, qos)) break;
+
+        segment.readOffset += 8 + length;
+        segment.records--;
+        storeReadOffset(segment);
+        stats.queued--;
+        stats.replayed++;
+        tokens -= 1.0;
+        sent++;
+    }
+    return sent;
+}
+
+//--> Copy of the counters
+SpoolMetrics Spool::metrics() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
@@ -0,0 +1,120 @@
+/*!
+ * \file      spool.hpp
+ * \brief     Disk backed store-and-forward queue for broker outages
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Messages that cannot be published are appended to memory-mapped segment
+ * files (spool-000001.seg, ...) of a fixed size. A segment starts with a 64
+ * byte header holding the read offset, followed by records:
+ *
+ *   u32 length of the rest | u32 crc32 of the rest | u8 qos | u16 topic length | topic | payload
+ *
+ * On startup the segments are scanned, the first record with a bad length or
+ * crc marks the end, so a record torn by a power cut is simply dropped.
+ * drain() replays the oldest records in order, limited by a token bucket so a
+ * long outage does not flood the broker on reconnect. Fully replayed segments
+ * are deleted. When maxSegments is reached the drop policy decides which data
+ * is lost.
+ *
+ */
+
+#ifndef SPOOL_HPP
+#define SPOOL_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <string_view>
+
+//--> What to do when the spool is full
+enum class SpoolDropPolicy {
+    DropOldest,         // delete the oldest segment to make room
+    DropNewest          // refuse the new message
+};
+
+//--> Spool settings
+struct SpoolOptions {
+    std::string directory = "spool";
+    size_t segmentSize = 1024 * 1024;               // bytes per segment file
+    size_t maxSegments = 64;                        // size cap = segmentSize * maxSegments
+    SpoolDropPolicy dropPolicy = SpoolDropPolicy::DropOldest;
+    double drainRate = 20.0;                        // messages per second during replay
+    size_t drainBurst = 20;                         // max messages replayed in one go
+};
+
+//--> Spool counters
+struct SpoolMetrics {
+    size_t queued;          // records waiting for replay
+    size_t segments;        // segment files on disk
+    uint64_t spooled;       // records appended
+    uint64_t replayed;      // records handed back for publishing
+    uint64_t dropped;       // records lost to the size cap
+};
+
+//--> Persistent FIFO of mqtt messages
+class Spool {
+
+//-> Public functions
+public:
+    //--> Send function for drain(), returns false when the message could not be taken (stop for now, it stays at the head)
+    //--> It runs under the spool lock, so it must not append to this spool
+    using SendFunction = std::function<bool(const std::string& topic, std::string_view payload, int qos)>;
+
+    //--> Constructor, opens or recovers the segments in the directory (throws std::runtime_error)
+    explicit Spool(const SpoolOptions& options);
+
+    //--> Destructor, flushes and unmaps the segments
+    ~Spool();
+
+    Spool(const Spool&) = delete;
+    Spool& operator=(const Spool&) = delete;
+
+    //--> Store one message, false when it was dropped
+    bool append(const std::string& topic, std::string_view payload, int qos);
+
+    //--> True when nothing is waiting
+    bool empty();
+
+    //--> Replay the oldest records in order, as many as the drain rate allows, returns how many
+    size_t drain(const SendFunction& send);
+
+    //--> Current counters
+    SpoolMetrics metrics();
+
+//-> Private functions and variables
+private:
+    //--> One mapped segment file
+    struct Segment {
+        uint64_t number;
+        int fd;
+        uint8_t* base;
+        size_t readOffset;
+        size_t writeOffset;
+        size_t records;
+    };
+
+    SpoolOptions options;
+    std::mutex lock;
+    std::deque<Segment> segments;
+    uint64_t nextNumber = 1;
+    SpoolMetrics stats{};
+    double tokens = 0.0;
+    int64_t lastDrainNs = 0;
+
+    //--> Segment file handling
+    std::string segmentPath(uint64_t number) const;
+    Segment openSegment(uint64_t number, bool create);
+    void closeSegment(Segment& segment, bool remove);
+    void scanSegment(Segment& segment);
+    void storeReadOffset(Segment& segment);
+
+    //--> Drop the oldest segment for room
+    void dropOldest();
+};
+
+#endif //--> SPOOL_HPP
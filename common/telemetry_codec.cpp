@@ -0,0 +1,102 @@
+/*!
+ * \file      telemetry_codec.cpp
+ * \brief     Compact binary telemetry records, encoder and decoder
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "telemetry_codec.hpp"
+#include <cmath>
+#include <limits>
+
+//--> Little-endian helpers, byte by byte so the host byte order does not matter
+static void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static void putU64(uint8_t* p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i);
+    return v;
+}
+
+static uint64_t getU64(const uint8_t* p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return v;
+}
+
+//--> Format option from the command line
+PayloadFormat parsePayloadFormat(const std::string& text) {
+    if (text == "binary") return PayloadFormat::Binary;
+    if (text == "both") return PayloadFormat::Both;
+    return PayloadFormat::Json;
+}
+
+//--> Fixed point divider per record type
+int32_t telemetryScale(TelemetryType type) {
+    switch (type) {
+        case TelemetryType::Sensor: return 100;
+        case TelemetryType::Vitals: return 10;
+        case TelemetryType::Waveform: return 1;
+    }
+    return 1;
+}
+
+//--> Physical value
+double TelemetryRecord::value(size_t i) const {
+    return static_cast<double>(raw[i]) / telemetryScale(type);
+}
+
+//--> Header plus rounded, clamped fixed point values
+size_t encodeTelemetry(uint8_t* out, size_t capacity, TelemetryType type, uint32_t sequence,
+                       int64_t timestampUs, const float* values, size_t count) {
+    size_t size = TELEMETRY_HEADER_SIZE + 4 * count;
+    if (count > TELEMETRY_MAX_VALUES || size > capacity) return 0;
+
+    out[0] = TELEMETRY_MAGIC;
+    out[1] = TELEMETRY_VERSION;
+    out[2] = static_cast<uint8_t>(type);
+    out[3] = static_cast<uint8_t>(count);
+    putU32(out + 4, sequence);
+    putU64(out + 8, static_cast<uint64_t>(timestampUs));
+
+    int32_t scale = telemetryScale(type);
+    for (size_t i = 0; i < count; i++) {
+        //--> NaN has no fixed point value, send the smallest i32 as "no value"
+        double v = std::isnan(values[i]) ? std::numeric_limits<int32_t>::min() : std::round(static_cast<double>(values[i]) * scale);
+        if (v < std::numeric_limits<int32_t>::min()) v = std::numeric_limits<int32_t>::min();
+        if (v > std::numeric_limits<int32_t>::max()) v = std::numeric_limits<int32_t>::max();
+        putU32(out + TELEMETRY_HEADER_SIZE + 4 * i, static_cast<uint32_t>(static_cast<int32_t>(v)));
+    }
+    return size;
+}
+
+//--> Check the header and read the values back
+bool decodeTelemetry(const uint8_t* data, size_t length, TelemetryRecord& record, size_t& used) {
+    used = 0;
+    if (length < TELEMETRY_HEADER_SIZE || data[0] != TELEMETRY_MAGIC) return false;
+
+    //--> Newer versions may change the layout, refuse instead of guessing, waveform frames have their own decoder
+    if (data[1] != TELEMETRY_VERSION || data[2] == static_cast<uint8_t>(TelemetryType::Waveform)) return false;
+
+    size_t count = data[3];
+    size_t size = TELEMETRY_HEADER_SIZE + 4 * count;
+    if (count > TELEMETRY_MAX_VALUES || length < size) return false;
+
+    record.type = static_cast<TelemetryType>(data[2]);
+    record.version = data[1];
+    record.sequence = getU32(data + 4);
+    record.timestampUs = static_cast<int64_t>(getU64(data + 8));
+    record.count = count;
+    for (size_t i = 0; i < count; i++) {
+        record.raw[i] = static_cast<int32_t>(getU32(data + TELEMETRY_HEADER_SIZE + 4 * i));
+    }
+    used = size;
+    return true;
+}
@@ -0,0 +1,85 @@
+/*!
+ * \file      telemetry_codec.hpp
+ * \brief     Compact binary telemetry records, encoder and decoder
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Binary alternative for the JSON payloads. A record is packed little-endian:
+ *
+ *   offset  size  field
+ *   0       1     magic 0xB7 (a JSON payload always starts with '{')
+ *   1       1     format version, currently 1
+ *   2       1     record type (TelemetryType)
+ *   3       1     number of values N
+ *   4       4     sequence number (u32, wraps)
+ *   8       8     acquisition time, unix us (i64)
+ *   16      4*N   values as fixed point i32, scale per record type
+ *
+ * A batch is just records back to back. Binary payloads are published on the
+ * "<topic>/bin" topic so JSON consumers never see them.
+ *
+ */
+
+#ifndef TELEMETRY_CODEC_HPP
+#define TELEMETRY_CODEC_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+//--> First byte of every binary record and the current version
+const uint8_t TELEMETRY_MAGIC = 0xB7;
+const uint8_t TELEMETRY_VERSION = 1;
+const size_t TELEMETRY_HEADER_SIZE = 16;
+const size_t TELEMETRY_MAX_VALUES = 16;
+
+//--> Topic suffix for binary payloads
+const std::string TELEMETRY_BINARY_SUFFIX{"/bin"};
+
+//--> Record types, the type fixes the order and scale of the values
+enum class TelemetryType : uint8_t {
+    Sensor = 1,         // temperature 0.01 °C, humidity 0.01 %, pressure 0.01 hPa (= Pa)
+    Vitals = 2,         // heartbeat, bloodpressure, bloodoxygen, breathspeed, bodytemperature, all 0.1
+    Waveform = 3        // own layout after the type byte, see PROG6_MQTT/waveform.hpp
+};
+
+//--> Which payloads a publisher sends
+enum class PayloadFormat {
+    Json,
+    Binary,
+    Both
+};
+
+//--> Parse "json", "binary" or "both", anything else is json
+PayloadFormat parsePayloadFormat(const std::string& text);
+
+//--> Decoded record
+struct TelemetryRecord {
+    TelemetryType type;
+    uint8_t version;
+    uint32_t sequence;
+    int64_t timestampUs;
+    size_t count;
+    int32_t raw[TELEMETRY_MAX_VALUES];      // fixed point as sent
+
+    //--> Value i in its physical unit
+    double value(size_t i) const;
+};
+
+//--> Divider of the fixed point values of a record type
+int32_t telemetryScale(TelemetryType type);
+
+//--> Encode one record, returns bytes written or 0 when it does not fit
+size_t encodeTelemetry(uint8_t* out, size_t capacity, TelemetryType type, uint32_t sequence,
+                       int64_t timestampUs, const float* values, size_t count);
+
+//--> Decode one record from the start of data, used tells how many bytes it took (0 on error)
+bool decodeTelemetry(const uint8_t* data, size_t length, TelemetryRecord& record, size_t& used);
+
+//--> True when a payload is a binary record instead of JSON text
+inline bool isBinaryTelemetry(const uint8_t* data, size_t length) {
+    return length > 0 && data[0] == TELEMETRY_MAGIC;
+}
+
+#endif //--> TELEMETRY_CODEC_HPP
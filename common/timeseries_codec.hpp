@@ -0,0 +1,193 @@
+/*!
+ * \file      timeseries_codec.hpp
+ * \brief     Compression of one block of samples: delta-of-delta timestamps, zig-zag varint values
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * A block holds the samples of one series in time order. The first
+ * timestamp is kept outside the block (in the block header of the store),
+ * inside it every sample is:
+ *
+ *   timestamp   sample 1: delta to sample 0, then: delta minus the previous delta
+ *   values      fixed point (value * scale, rounded), minus the previous value
+ *
+ * every number zig-zag encoded (small negatives become small positives) and
+ * written as a varint (7 bits per byte, high bit = more). A sensor sampled
+ * at 1 Hz has a delta-of-delta of a few hundred us of jitter, 2 bytes, and
+ * values that change by a few steps of 0.01, 1 byte each: a BME280 sample
+ * (8 byte time + 3 floats) goes from 20 bytes to about 5.
+ *
+ * The values are fixed point because the sensors are: the BME280 gives
+ * 0.01 °C, which no float holds exactly, so XOR (Gorilla) compression of the
+ * floats would keep noise in the low mantissa bits that the sensor never
+ * measured. A value that is not finite is stored as TIMESERIES_MISSING and
+ * read back as NaN.
+ *
+ * While encoding, the block also keeps a summary per value (count, min, max
+ * and sum of the values that are not missing), stored in the block header
+ * so aggregate queries over whole blocks never have to decode them.
+ *
+ */
+
+#ifndef TIMESERIES_CODEC_HPP
+#define TIMESERIES_CODEC_HPP
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+//--> Max values per sample and the fixed point value of a missing (NaN) value
+const size_t TIMESERIES_MAX_VALUES = 16;
+const int64_t TIMESERIES_MISSING = INT32_MIN;
+
+//--> Zig-zag: 0, -1, 1, -2, 2 ... become 0, 1, 2, 3, 4 ...
+inline uint64_t zigzagEncode(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+inline int64_t zigzagDecode(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+//--> Append a varint
+inline void putVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+//--> Read a varint, false when the data ends in the middle of it
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        uint8_t byte = *p++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+//--> Value to fixed point with a scale (100 = 0.01 steps)
+inline int64_t toFixed(float value, int32_t scale) {
+    if (!std::isfinite(value)) return TIMESERIES_MISSING;
+    double fixed = std::nearbyint(static_cast<double>(value) * scale);
+    if (fixed <= TIMESERIES_MISSING) return TIMESERIES_MISSING + 1;
+    if (fixed > INT32_MAX) return INT32_MAX;
+    return static_cast<int64_t>(fixed);
+}
+
+//--> Fixed point back to the value
+inline float fromFixed(int64_t fixed, int32_t scale) {
+    if (fixed == TIMESERIES_MISSING) return std::numeric_limits<float>::quiet_NaN();
+    return static_cast<float>(static_cast<double>(fixed) / scale);
+}
+
+//--> Count, min, max and sum of one value over a block, fixed point, missing values left out
+struct SeriesSummary {
+    uint32_t count;
+    int64_t min;
+    int64_t max;
+    int64_t sum;
+};
+
+//--> Add one fixed point value to a summary
+inline void summarise(SeriesSummary& summary, int64_t fixed) {
+    if (fixed == TIMESERIES_MISSING) return;
+    if (summary.count == 0 || fixed < summary.min) summary.min = fixed;
+    if (summary.count == 0 || fixed > summary.max) summary.max = fixed;
+    summary.sum += fixed;
+    summary.count++;
+}
+
+//--> Builds one block, append samples in time order
+class SeriesBlockEncoder {
+
+//-> Public functions
+public:
+    //--> Start a new block for samples of count values
+    void reset(size_t valueCount) {
+        values = valueCount;
+        samples = 0;
+        data.clear();
+        for (size_t i = 0; i < values; i++) summaries[i] = {};
+    }
+
+    //--> Add one sample, fixed holds one fixed point value per value
+    void add(int64_t timestampUs, const int64_t* fixed) {
+        if (samples == 0) {
+            firstUs = timestampUs;
+            for (size_t i = 0; i < values; i++) putVarint(data, zigzagEncode(fixed[i]));
+        } else {
+            int64_t delta = timestampUs - lastUs;
+            putVarint(data, zigzagEncode(samples == 1 ? delta : delta - lastDelta));
+            lastDelta = delta;
+            for (size_t i = 0; i < values; i++) putVarint(data, zigzagEncode(fixed[i] - previous[i]));
+        }
+        for (size_t i = 0; i < values; i++) {
+            previous[i] = fixed[i];
+            summarise(summaries[i], fixed[i]);
+        }
+        lastUs = timestampUs;
+        samples++;
+    }
+
+    //--> Samples, time span and encoded bytes of the block so far
+    size_t count() const { return samples; }
+    int64_t firstTimestamp() const { return firstUs; }
+    int64_t lastTimestamp() const { return lastUs; }
+    const std::vector<uint8_t>& bytes() const { return data; }
+    const SeriesSummary& summary(size_t value) const { return summaries[value]; }
+
+//-> Private functions and variables
+private:
+    size_t values = 0;
+    size_t samples = 0;
+    int64_t firstUs = 0;
+    int64_t lastUs = 0;
+    int64_t lastDelta = 0;
+    int64_t previous[TIMESERIES_MAX_VALUES] = {};
+    SeriesSummary summaries[TIMESERIES_MAX_VALUES] = {};
+    std::vector<uint8_t> data;
+};
+
+//--> Walks the samples of one block
+class SeriesBlockDecoder {
+
+//-> Public functions
+public:
+    //--> Constructor, data has to outlive the decoder
+    SeriesBlockDecoder(const uint8_t* data, size_t length, size_t valueCount, size_t sampleCount, int64_t firstUs)
+        : p(data), end(data + length), values(valueCount), samples(sampleCount), timestampUs(firstUs) {}
+
+    //--> Next sample, fixed gets one fixed point value per value, false at the end or on corrupt data
+    bool next(int64_t& timestamp, int64_t* fixed) {
+        if (done >= samples || values > TIMESERIES_MAX_VALUES) return false;
+        uint64_t raw;
+        if (done > 0) {
+            if (!getVarint(p, end, raw)) return false;
+            delta = done == 1 ? zigzagDecode(raw) : delta + zigzagDecode(raw);
+            timestampUs += delta;
+        }
+        for (size_t i = 0; i < values; i++) {
+            if (!getVarint(p, end, raw)) return false;
+            previous[i] = done == 0 ? zigzagDecode(raw) : previous[i] + zigzagDecode(raw);
+            fixed[i] = previous[i];
+        }
+        timestamp = timestampUs;
+        done++;
+        return true;
+    }
+
+//-> Private functions and variables
+private:
+    const uint8_t* p;
+    const uint8_t* end;
+    size_t values;
+    size_t samples;
+    size_t done = 0;
+    int64_t timestampUs;
+    int64_t delta = 0;
+    int64_t previous[TIMESERIES_MAX_VALUES] = {};
+};
+
+#endif //--> TIMESERIES_CODEC_HPP
@@ -0,0 +1,368 @@
+/*!
+ * \file      timeseries_index.cpp
+ * \brief     Sparse time index of one segment of the time-series store, read through mmap
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "timeseries_index.hpp"
+#include "crc32.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//--> Little-endian helpers
+template <typename T>
+static T get(const uint8_t* p) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < sizeof(T); i++) v |= static_cast<uint64_t>(p[i]) << (8 * i);
+    return static_cast<T>(v);
+}
+template <typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+    for (size_t i = 0; i < sizeof(T); i++) out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+}
+
+//--> Index path of a segment path, .seg becomes .idx
+std::string timeSeriesIndexPath(const std::string& segmentPath) {
+    size_t dot = segmentPath.rfind('.');
+    return (dot == std::string::npos ? segmentPath : segmentPath.substr(0, dot)) + ".idx";
+}
+
+//--> Segments by the partition start in their name (ts-20261018T0000.seg, UTC)
+std::vector<std::pair<int64_t, std::string>> listTimeSeriesSegments(const std::string& directory) {
+    std::vector<std::pair<int64_t, std::string>> segments;
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) return segments;
+    while (dirent* entry = readdir(dir)) {
+        struct tm utc{};
+        int used = 0;
+        if (std::sscanf(entry->d_name, "ts-%4d%2d%2dT%2d%2d.seg%n", &utc.tm_year, &utc.tm_mon, &utc.tm_mday,
+                        &utc.tm_hour, &utc.tm_min, &used) != 5 || entry->d_name[used] != '\0') continue;
+        utc.tm_year -= 1900;
+        utc.tm_mon -= 1;
+        segments.push_back({static_cast<int64_t>(timegm(&utc)) * 1000000, directory + "/" + entry->d_name});
+    }
+    closedir(dir);
+    std::sort(segments.begin(), segments.end());
+    return segments;
+}
+
+//--> Seal the finished segments that lack a (valid) index file
+size_t sealTimeSeriesSegments(const std::string& directory, int64_t beforeUs) {
+    size_t sealed = 0;
+    for (const auto& segment : listTimeSeriesSegments(directory)) {
+        if (segment.first >= beforeUs) break;
+        SegmentIndex index;
+        if (index.open(segment.second) && !index.fromFile() && index.seal()) sealed++;
+    }
+    return sealed;
+}
+
+//--> Destructor
+SegmentIndex::~SegmentIndex() {
+    dropIndex();
+    if (data) munmap(const_cast<uint8_t*>(data), dataSize);
+    if (fd >= 0) close(fd);
+}
+
+//--> Map the segment, check its header, then load or build the index
+bool SegmentIndex::open(const std::string& segmentPath) {
+    path = segmentPath;
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < TS_HEADER_SIZE || !map(static_cast<size_t>(info.st_size))) return false;
+    if (std::memcmp(data, TS_MAGIC, 8) != 0) return false;
+    partitionUs = get<int64_t>(data + 8);
+    scanned = TS_HEADER_SIZE;
+    if (!loadIndex()) scan();
+    return true;
+}
+
+//--> The live segment grows, a reopened one may have lost its torn tail
+bool SegmentIndex::refresh() {
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0) return false;
+    size_t size = static_cast<size_t>(info.st_size);
+    if (size == dataSize) return true;
+    if (fromFile() || size < scanned) {
+        dropIndex();
+        series.clear();
+        ids.clear();
+        scanned = TS_HEADER_SIZE;
+    }
+    if (size < TS_HEADER_SIZE || !map(size)) return false;
+    scan();
+    return true;
+}
+
+//--> (Re)map the whole segment read-only
+bool SegmentIndex::map(size_t size) {
+    if (data) munmap(const_cast<uint8_t*>(data), dataSize);
+    data = nullptr;
+    dataSize = 0;
+    void* m = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED) return false;
+    data = static_cast<const uint8_t*>(m);
+    dataSize = size;
+    return true;
+}
+
+//--> Use the index file when it covers the segment as it is now, only its series headers are read
+bool SegmentIndex::loadIndex() {
+    int file = ::open(timeSeriesIndexPath(path).c_str(), O_RDONLY);
+    if (file < 0) return false;
+    struct stat info;
+    void* m = MAP_FAILED;
+    if (fstat(file, &info) == 0 && info.st_size >= TS_INDEX_HEADER) {
+        m = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_SHARED, file, 0);
+    }
+    close(file);
+    if (m == MAP_FAILED) return false;
+    indexMap = static_cast<const uint8_t*>(m);
+    indexSize = static_cast<size_t>(info.st_size);
+
+    const uint8_t* p = indexMap;
+    const uint8_t* end = indexMap + indexSize;
+    if (std::memcmp(p, TS_INDEX_MAGIC, 8) != 0 || get<uint64_t>(p + 8) != dataSize) {
+        dropIndex();
+        return false;
+    }
+    uint32_t count = get<uint32_t>(p + 16);
+    p += TS_INDEX_HEADER;
+    for (uint32_t n = 0; n < count; n++) {
+        Series s;
+        if (end - p < 2) break;
+        size_t values = p[0], nameLength = p[1];
+        p += 2;
+        if (values == 0 || values > TIMESERIES_MAX_VALUES || static_cast<size_t>(end - p) < nameLength) break;
+        s.name.assign(reinterpret_cast<const char*>(p), nameLength);
+        p += nameLength;
+        for (size_t v = 0; v < values && p < end; v++) {
+            size_t length = *p++;
+            if (static_cast<size_t>(end - p) < length + 4) break;
+            s.fields.emplace_back(reinterpret_cast<const char*>(p), length);
+            s.scales.push_back(get<int32_t>(p + length));
+            p += length + 4;
+        }
+        if (s.fields.size() != values || end - p < 4) break;
+        s.count = get<uint32_t>(p);
+        p += 4;
+        if (static_cast<size_t>(end - p) / s.entrySize() < s.count) break;
+        s.sealed = p;
+        p += s.count * s.entrySize();
+        series.push_back(std::move(s));
+    }
+
+    //--> A damaged index file is worth less than a scan
+    if (series.size() != count) {
+        dropIndex();
+        return false;
+    }
+    scanned = dataSize;
+    return true;
+}
+
+//--> Forget the index file and the series that point into it
+void SegmentIndex::dropIndex() {
+    if (!indexMap) return;
+    munmap(const_cast<uint8_t*>(indexMap), indexSize);
+    indexMap = nullptr;
+    indexSize = 0;
+    series.clear();
+}
+
+//--> Walk the records from where the last scan stopped, up to the first one that is torn or still being written
+void SegmentIndex::scan() {
+    size_t at = scanned;
+    while (at + TS_RECORD_HEAD <= dataSize) {
+        size_t length = get<uint32_t>(data + at);
+        if (length == 0 || length > dataSize - at - TS_RECORD_HEAD) break;
+        const uint8_t* record = data + at + TS_RECORD_HEAD;
+        if (crc32(record, length) != get<uint32_t>(data + at + 4)) break;
+        const uint8_t* end = record + length;
+        if (record[0] == TS_KIND_SERIES) {
+            define(record + 1, end);
+        } else if (record[0] == TS_KIND_BLOCK || record[0] == TS_KIND_SUMMARY) {
+            auto id = ids.find(length >= 3 ? get<uint16_t>(record + 1) : 0);
+            if (length >= 3 && id != ids.end()) addBlock(id->second, record + 3, end, record[0] == TS_KIND_SUMMARY);
+        }
+        at += TS_RECORD_HEAD + length;
+    }
+    scanTotal += at - scanned;
+    scanned = at;
+
+    //--> Blocks out of order (the clock stepped back) are rare, sort the entries then
+    for (Series& s : series) {
+        if (s.sorted) continue;
+        size_t size = s.entrySize();
+        std::vector<size_t> order(s.count);
+        for (size_t i = 0; i < s.count; i++) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&s, size](size_t a, size_t b) {
+            return get<int64_t>(s.built.data() + a * size) < get<int64_t>(s.built.data() + b * size);
+        });
+        std::vector<uint8_t> sorted;
+        sorted.reserve(s.built.size());
+        for (size_t i : order) sorted.insert(sorted.end(), s.built.begin() + i * size, s.built.begin() + (i + 1) * size);
+        s.built.swap(sorted);
+        s.sorted = true;
+    }
+}
+
+//--> Series record: u16 id | u8 values | u8 name length | name | per value: u8 length | name | i32 scale
+void SegmentIndex::define(const uint8_t* p, const uint8_t* end) {
+    if (end - p < 4) return;
+    uint16_t id = get<uint16_t>(p);
+    size_t values = p[2], nameLength = p[3];
+    p += 4;
+    if (values == 0 || values > TIMESERIES_MAX_VALUES || static_cast<size_t>(end - p) < nameLength) return;
+    Series s;
+    s.name.assign(reinterpret_cast<const char*>(p), nameLength);
+    p += nameLength;
+    for (size_t v = 0; v < values; v++) {
+        if (p >= end) return;
+        size_t length = *p++;
+        if (static_cast<size_t>(end - p) < length + 4) return;
+        s.fields.emplace_back(reinterpret_cast<const char*>(p), length);
+        s.scales.push_back(get<int32_t>(p + length));
+        p += length + 4;
+    }
+
+    //--> The same series defined again (a new run, another id) continues the entries it has
+    size_t index = 0;
+    while (index < series.size() &&
+           (series[index].name != s.name || series[index].fields != s.fields || series[index].scales != s.scales)) index++;
+    if (index == series.size()) series.push_back(std::move(s));
+    ids[id] = index;
+}
+
+//--> Block record after the id: u16 samples | i64 first | i64 last | [summaries] | compressed samples
+void SegmentIndex::addBlock(size_t index, const uint8_t* p, const uint8_t* end, bool summarised) {
+    Series& s = series[index];
+    if (end - p < 18) return;
+    uint16_t samples = get<uint16_t>(p);
+    int64_t firstUs = get<int64_t>(p + 2);
+    int64_t lastUs = get<int64_t>(p + 10);
+    p += 18;
+
+    SeriesSummary summaries[TIMESERIES_MAX_VALUES] = {};
+    if (summarised) {
+        for (size_t v = 0; v < s.fields.size(); v++) {
+            uint64_t count, min, max, sum;
+            if (!getVarint(p, end, count) || !getVarint(p, end, min) || !getVarint(p, end, max) || !getVarint(p, end, sum)) return;
+            summaries[v] = {static_cast<uint32_t>(count), zigzagDecode(min), zigzagDecode(max), zigzagDecode(sum)};
+        }
+    } else {
+        //--> Older blocks carry no summary, decode them once here
+        SeriesBlockDecoder decoder(p, static_cast<size_t>(end - p), s.fields.size(), samples, firstUs);
+        int64_t timestampUs, fixed[TIMESERIES_MAX_VALUES];
+        while (decoder.next(timestampUs, fixed)) {
+            for (size_t v = 0; v < s.fields.size(); v++) summarise(summaries[v], fixed[v]);
+        }
+    }
+
+    if (s.count > 0 && firstUs < get<int64_t>(s.built.data() + (s.count - 1) * s.entrySize())) s.sorted = false;
+    put<int64_t>(s.built, firstUs);
+    put<int64_t>(s.built, lastUs);
+    put<uint32_t>(s.built, static_cast<uint32_t>(p - data));
+    put<uint32_t>(s.built, static_cast<uint32_t>(end - p));
+    put<uint16_t>(s.built, samples);
+    for (size_t v = 0; v < s.fields.size(); v++) {
+        put<uint32_t>(s.built, summaries[v].count);
+        put<int32_t>(s.built, static_cast<int32_t>(summaries[v].min));
+        put<int32_t>(s.built, static_cast<int32_t>(summaries[v].max));
+        put<int64_t>(s.built, summaries[v].sum);
+    }
+    s.count++;
+}
+
+//--> Write the index to a temporary file, sync it and rename it over the old one
+bool SegmentIndex::seal() const {
+    std::vector<uint8_t> out;
+    out.insert(out.end(), TS_INDEX_MAGIC, TS_INDEX_MAGIC + 8);
+    put<uint64_t>(out, dataSize);
+    put<uint32_t>(out, static_cast<uint32_t>(series.size()));
+    put<uint32_t>(out, 0);
+    for (const Series& s : series) {
+        put<uint8_t>(out, static_cast<uint8_t>(s.fields.size()));
+        put<uint8_t>(out, static_cast<uint8_t>(s.name.size()));
+        out.insert(out.end(), s.name.begin(), s.name.end());
+        for (size_t v = 0; v < s.fields.size(); v++) {
+            put<uint8_t>(out, static_cast<uint8_t>(s.fields[v].size()));
+            out.insert(out.end(), s.fields[v].begin(), s.fields[v].end());
+            put<int32_t>(out, s.scales[v]);
+        }
+        put<uint32_t>(out, static_cast<uint32_t>(s.count));
+        out.insert(out.end(), s.entries(), s.entries() + s.count * s.entrySize());
+    }
+
+    std::string target = timeSeriesIndexPath(path);
+    std::string temporary = target + ".tmp";
+    int file = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+        std::perror(("cannot write time series index " + temporary).c_str());
+        return false;
+    }
+    bool ok = ::write(file, out.data(), out.size()) == static_cast<ssize_t>(out.size()) && fdatasync(file) == 0;
+    close(file);
+    if (!ok || rename(temporary.c_str(), target.c_str()) != 0) {
+        std::perror(("cannot write time series index " + target).c_str());
+        unlink(temporary.c_str());
+        return false;
+    }
+
+    //--> The rename has to survive a power cut too
+    size_t slash = target.rfind('/');
+    int dirFd = ::open(slash == std::string::npos ? "." : target.substr(0, slash).c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+    return true;
+}
+
+//--> Series by name
+const SegmentIndex::Series* SegmentIndex::find(const std::string& name) const {
+    for (const Series& s : series) {
+        if (s.name == name) return &s;
+    }
+    return nullptr;
+}
+
+//--> Entry i of a series
+IndexedBlock SegmentIndex::block(const Series& s, size_t i, SeriesSummary* summaries) const {
+    const uint8_t* p = s.entries() + i * s.entrySize();
+    IndexedBlock b{get<int64_t>(p), get<int64_t>(p + 8), get<uint32_t>(p + 16), get<uint32_t>(p + 20), get<uint16_t>(p + 24)};
+    if (summaries) {
+        p += TS_ENTRY_HEAD;
+        for (size_t v = 0; v < s.fields.size(); v++, p += TS_ENTRY_VALUE) {
+            summaries[v] = {get<uint32_t>(p), get<int32_t>(p + 4), get<int32_t>(p + 8), get<int64_t>(p + 12)};
+        }
+    }
+    return b;
+}
+
+//--> Binary search on the last timestamps, the blocks of a series do not overlap
+size_t SegmentIndex::lowerBound(const Series& s, int64_t timestampUs) const {
+    size_t low = 0, high = s.count;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (get<int64_t>(s.entries() + middle * s.entrySize() + 8) < timestampUs) low = middle + 1;
+        else high = middle;
+    }
+    return low;
+}
+
+//--> Compressed samples of a block in the mapped segment
+const uint8_t* SegmentIndex::samples(const IndexedBlock& b) const {
+    if (static_cast<size_t>(b.offset) + b.length > dataSize) return nullptr;
+    return data + b.offset;
+}
@@ -0,0 +1,158 @@
+/*!
+ * \file      timeseries_index.hpp
+ * \brief     Sparse time index of one segment of the time-series store, read through mmap
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * The index holds one entry per block, not per sample: per series the
+ * blocks of the segment in time order, with where their compressed samples
+ * are in the segment and the summary of every value (count, min, max, sum,
+ * fixed point). A query finds its first block with a binary search, sums
+ * the blocks that lie inside its window from the entries alone and decodes
+ * only the blocks on the edges. The segment itself is memory mapped, so
+ * reading a block touches just the pages it is on.
+ *
+ * Where the index comes from:
+ *
+ *   sealed    when the store moves on to the next partition the writer
+ *             writes the index of the finished segment to a file next to
+ *             it (ts-20261018T0000.idx). Loading it only reads the series
+ *             headers, the entries of a series are used in place.
+ *   scanned   the segment still being written (or one without an index
+ *             file) is walked record by record, the block headers hold the
+ *             summaries. Later calls only scan what was appended since.
+ *
+ * Index file, integers little-endian, written to a temporary file, synced
+ * and renamed, so it is either complete or not there:
+ *
+ *   "TSIDX001" | u64 segment size it covers | u32 series | u32 0
+ *   per series: u8 values | u8 name length | name | per value: u8 length | name | i32 scale
+ *               u32 entries | entries
+ *   entry:      i64 first us | i64 last us | u32 offset | u32 length | u16 samples
+ *               per value: u32 count | i32 min | i32 max | i64 sum
+ *
+ * offset and length point at the compressed samples in the segment. An
+ * index file whose size does not match the segment any more is ignored.
+ *
+ */
+
+#ifndef TIMESERIES_INDEX_HPP
+#define TIMESERIES_INDEX_HPP
+
+#include "timeseries_codec.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+//--> Segment layout, see timeseries_store.hpp
+#define TS_MAGIC            "TSSEG001"
+#define TS_HEADER_SIZE      16          // magic, partition start
+#define TS_RECORD_HEAD      8           // length, crc
+#define TS_KIND_SERIES      1
+#define TS_KIND_BLOCK       2           // block without summaries, written before they existed
+#define TS_KIND_SUMMARY     3           // block with a summary per value
+
+//--> Index file layout
+#define TS_INDEX_MAGIC      "TSIDX001"
+#define TS_INDEX_HEADER     24
+#define TS_ENTRY_HEAD       26          // first, last, offset, length, samples
+#define TS_ENTRY_VALUE      20          // count, min, max, sum
+
+//--> One block of a series as found in the index
+struct IndexedBlock {
+    int64_t firstUs;
+    int64_t lastUs;
+    uint32_t offset;            // compressed samples in the segment
+    uint32_t length;
+    uint16_t samples;
+};
+
+//--> Index of one segment file
+class SegmentIndex {
+
+//-> Public functions
+public:
+    //--> One series of the segment, series with the same name and fields share one
+    struct Series {
+        std::string name;
+        std::vector<std::string> fields;
+        std::vector<int32_t> scales;
+        size_t count = 0;                   // blocks
+        const uint8_t* sealed = nullptr;    // entries in the mapped index file
+        std::vector<uint8_t> built;         // or scanned here
+        bool sorted = true;
+
+        size_t entrySize() const { return TS_ENTRY_HEAD + TS_ENTRY_VALUE * fields.size(); }
+        const uint8_t* entries() const { return sealed ? sealed : built.data(); }
+    };
+
+    SegmentIndex() = default;
+    ~SegmentIndex();
+
+    SegmentIndex(const SegmentIndex&) = delete;
+    SegmentIndex& operator=(const SegmentIndex&) = delete;
+
+    //--> Map the segment and load its index file, or scan it when there is none, false when it is no segment
+    bool open(const std::string& segmentPath);
+
+    //--> Pick up records appended since the last call (remapping the segment), false on an error
+    bool refresh();
+
+    //--> Write the index file next to the segment
+    bool seal() const;
+
+    //--> Series of the segment, nullptr when it has none with that name
+    const Series* find(const std::string& name) const;
+    const std::vector<Series>& all() const { return series; }
+
+    //--> Block i of a series, with one summary per value when summaries is not nullptr
+    IndexedBlock block(const Series& s, size_t i, SeriesSummary* summaries) const;
+
+    //--> First block that ends at or after timestampUs
+    size_t lowerBound(const Series& s, int64_t timestampUs) const;
+
+    //--> Compressed samples of a block, nullptr when the index points outside the segment
+    const uint8_t* samples(const IndexedBlock& b) const;
+
+    //--> Partition start, mapped size, bytes walked by scans and whether the index came from a file
+    int64_t partition() const { return partitionUs; }
+    size_t size() const { return dataSize; }
+    size_t scannedBytes() const { return scanTotal; }
+    bool fromFile() const { return indexMap != nullptr; }
+
+//-> Private functions and variables
+private:
+    std::string path;
+    int fd = -1;
+    const uint8_t* data = nullptr;      // mapped segment
+    size_t dataSize = 0;
+    const uint8_t* indexMap = nullptr;  // mapped index file
+    size_t indexSize = 0;
+    int64_t partitionUs = 0;
+    size_t scanned = 0;                 // segment bytes walked so far
+    size_t scanTotal = 0;
+    std::vector<Series> series;
+    std::unordered_map<uint16_t, size_t> ids;   // series id in the segment -> series
+
+    bool map(size_t size);
+    bool loadIndex();
+    void dropIndex();
+    void scan();
+    void define(const uint8_t* p, const uint8_t* end);
+    void addBlock(size_t s, const uint8_t* p, const uint8_t* end, bool summarised);
+};
+
+//--> Index path of a segment path
+std::string timeSeriesIndexPath(const std::string& segmentPath);
+
+//--> Partition start and path of every segment in directory, oldest first
+std::vector<std::pair<int64_t, std::string>> listTimeSeriesSegments(const std::string& directory);
+
+//--> Seal every segment in directory of a partition before beforeUs that has no valid index file, returns how many
+size_t sealTimeSeriesSegments(const std::string& directory, int64_t beforeUs);
+
+#endif //--> TIMESERIES_INDEX_HPP
@@ -0,0 +1,145 @@
+/*!
+ * \file      timeseries_reader.cpp
+ * \brief     Range and aggregate queries on the local time-series store
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "timeseries_reader.hpp"
+#include <algorithm>
+#include <limits>
+
+//--> Running aggregate of one value, in the unit of the value
+struct Accumulator {
+    uint64_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double sum = 0.0;
+
+    void add(const SeriesSummary& s, int32_t scale) {
+        if (s.count == 0) return;
+        double low = static_cast<double>(s.min) / scale, high = static_cast<double>(s.max) / scale;
+        if (count == 0 || low < min) min = low;
+        if (count == 0 || high > max) max = high;
+        sum += static_cast<double>(s.sum) / scale;
+        count += s.count;
+    }
+};
+
+//--> Constructor
+TimeSeriesReader::TimeSeriesReader(const std::string& dir) : directory(dir) {}
+
+//--> Fields from the newest segment that has the series
+std::vector<std::string> TimeSeriesReader::fields(const std::string& series) {
+    auto list = listTimeSeriesSegments(directory);
+    for (auto it = list.rbegin(); it != list.rend(); ++it) {
+        SegmentIndex* index = segment(it->first, it->second);
+        if (!index) continue;
+        if (const SegmentIndex::Series* s = index->find(series)) return s->fields;
+    }
+    return {};
+}
+
+//--> Decode the blocks that overlap the window
+size_t TimeSeriesReader::samples(const std::string& series, int64_t fromUs, int64_t toUs, const SampleVisitor& visit) {
+    stats.queries++;
+    size_t visited = 0;
+    int64_t timestampUs, fixed[TIMESERIES_MAX_VALUES];
+    float values[TIMESERIES_MAX_VALUES];
+    for (SegmentIndex* index : segments(fromUs, toUs)) {
+        const SegmentIndex::Series* s = index->find(series);
+        if (!s) continue;
+        size_t count = s->fields.size();
+        for (size_t i = index->lowerBound(*s, fromUs); i < s->count; i++) {
+            IndexedBlock b = index->block(*s, i, nullptr);
+            if (b.firstUs >= toUs) break;
+            const uint8_t* data = index->samples(b);
+            if (!data) continue;
+            stats.decoded++;
+            SeriesBlockDecoder decoder(data, b.length, count, b.samples, b.firstUs);
+            while (decoder.next(timestampUs, fixed) && timestampUs < toUs) {
+                if (timestampUs < fromUs) continue;
+                for (size_t v = 0; v < count; v++) values[v] = fromFixed(fixed[v], s->scales[v]);
+                visit(timestampUs, values);
+                visited++;
+            }
+        }
+    }
+    return visited;
+}
+
+//--> Summaries of the blocks inside the window, decoded samples of the blocks on its edges
+size_t TimeSeriesReader::aggregate(const std::string& series, int64_t fromUs, int64_t toUs, TimeSeriesStats* out) {
+    stats.queries++;
+    size_t count = 0;
+    Accumulator total[TIMESERIES_MAX_VALUES];
+    SeriesSummary summaries[TIMESERIES_MAX_VALUES];
+    int64_t timestampUs, fixed[TIMESERIES_MAX_VALUES];
+    for (SegmentIndex* index : segments(fromUs, toUs)) {
+        const SegmentIndex::Series* s = index->find(series);
+        if (!s) continue;
+        if (count == 0) count = s->fields.size();
+        size_t values = std::min(count, s->fields.size());
+        for (size_t i = index->lowerBound(*s, fromUs); i < s->count; i++) {
+            IndexedBlock b = index->block(*s, i, summaries);
+            if (b.firstUs >= toUs) break;
+            if (b.firstUs >= fromUs && b.lastUs < toUs) {
+                for (size_t v = 0; v < values; v++) total[v].add(summaries[v], s->scales[v]);
+                stats.summarised++;
+                continue;
+            }
+
+            //--> Partly inside: summarise the samples that are
+            const uint8_t* data = index->samples(b);
+            if (!data) continue;
+            stats.decoded++;
+            for (size_t v = 0; v < values; v++) summaries[v] = {};
+            SeriesBlockDecoder decoder(data, b.length, s->fields.size(), b.samples, b.firstUs);
+            while (decoder.next(timestampUs, fixed) && timestampUs < toUs) {
+                if (timestampUs < fromUs) continue;
+                for (size_t v = 0; v < values; v++) summarise(summaries[v], fixed[v]);
+            }
+            for (size_t v = 0; v < values; v++) total[v].add(summaries[v], s->scales[v]);
+        }
+    }
+
+    const double none = std::numeric_limits<double>::quiet_NaN();
+    for (size_t v = 0; v < count; v++) {
+        const Accumulator& a = total[v];
+        out[v] = a.count ? TimeSeriesStats{a.count, a.min, a.max, a.sum / a.count} : TimeSeriesStats{0, none, none, none};
+    }
+    return count;
+}
+
+//--> Current counters, the scanned bytes summed over the open segments
+TimeSeriesQueryMetrics TimeSeriesReader::metrics() const {
+    TimeSeriesQueryMetrics m = stats;
+    m.scannedBytes = 0;
+    for (const auto& index : opened) m.scannedBytes += index.second->scannedBytes();
+    return m;
+}
+
+//--> Segments whose partition overlaps the window, each covers its start up to the start of the next one
+std::vector<SegmentIndex*> TimeSeriesReader::segments(int64_t fromUs, int64_t toUs) {
+    std::vector<SegmentIndex*> result;
+    auto list = listTimeSeriesSegments(directory);
+    for (size_t i = 0; i < list.size(); i++) {
+        int64_t end = i + 1 < list.size() ? list[i + 1].first : INT64_MAX;
+        if (list[i].first >= toUs || end <= fromUs) continue;
+        if (SegmentIndex* index = segment(list[i].first, list[i].second)) result.push_back(index);
+    }
+    return result;
+}
+
+//--> Open a segment the first time, pick up what was appended to it the next times
+SegmentIndex* TimeSeriesReader::segment(int64_t partitionUs, const std::string& path) {
+    auto it = opened.find(partitionUs);
+    if (it != opened.end()) return it->second->refresh() ? it->second.get() : nullptr;
+
+    auto index = std::make_unique<SegmentIndex>();
+    if (!index->open(path)) return nullptr;
+    stats.segments++;
+    if (index->fromFile()) stats.sealed++;
+    return opened.emplace(partitionUs, std::move(index)).first->second.get();
+}
@@ -0,0 +1,381 @@
+/*!
+ * \file      timeseries_store.cpp
+ * \brief     Local compressed time-series store in time-partitioned, append-only segment files
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "timeseries_store.hpp"
+#include "clock.hpp"
+#include "crc32.hpp"
+#include "timeseries_index.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//--> Samples per block, the rest of the layout is in timeseries_index.hpp
+#define TS_MAX_BLOCK        65535
+
+//--> Little-endian helpers
+static void putU32(uint8_t* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = static_cast<uint8_t>(v >> (8 * i)); }
+static uint32_t getU32(const uint8_t* p) { uint32_t v = 0; for (int i = 0; i < 4; i++) v |= static_cast<uint32_t>(p[i]) << (8 * i); return v; }
+template <typename T>
+static void put(std::vector<uint8_t>& out, T value) {
+    for (size_t i = 0; i < sizeof(T); i++) out.push_back(static_cast<uint8_t>(static_cast<uint64_t>(value) >> (8 * i)));
+}
+
+//--> Reserve the record head, returns where the record starts
+static size_t beginRecord(std::vector<uint8_t>& out, uint8_t kind) {
+    size_t start = out.size();
+    out.resize(start + TS_RECORD_HEAD);
+    out.push_back(kind);
+    return start;
+}
+
+//--> Fill in length and crc of the record that starts at start
+static void endRecord(std::vector<uint8_t>& out, size_t start) {
+    size_t length = out.size() - start - TS_RECORD_HEAD;
+    putU32(out.data() + start, static_cast<uint32_t>(length));
+    putU32(out.data() + start + 4, crc32(out.data() + start + TS_RECORD_HEAD, length));
+}
+
+//--> Path of the segment of a partition, named after its start in UTC
+std::string timeSeriesSegmentPath(const std::string& directory, int64_t partitionUs) {
+    time_t seconds = static_cast<time_t>(partitionUs / 1000000);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+    char name[32];
+    std::strftime(name, sizeof(name), "ts-%Y%m%dT%H%M.seg", &utc);
+    return directory + "/" + name;
+}
+
+//--> Constructor
+TimeSeriesStore::TimeSeriesStore(const TimeSeriesOptions& opts)
+    : options(opts), partitionUs(std::chrono::duration_cast<std::chrono::microseconds>(opts.partition).count()) {
+    if (partitionUs <= 0) throw std::runtime_error("time series partition must be positive");
+    if (options.blockSize < 64) throw std::runtime_error("time series block size too small");
+    if (mkdir(options.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        throw std::runtime_error("cannot create time series directory: " + options.directory);
+    }
+    lastHandOverNs = monotonicNs();
+    writer = std::thread(&TimeSeriesStore::run, this);
+}
+
+//--> Destructor
+TimeSeriesStore::~TimeSeriesStore() {
+    flush();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        running = false;
+    }
+    changed.notify_all();
+    writer.join();
+    if (fd >= 0) close(fd);
+}
+
+//--> New series, checked here so append() does not have to
+uint16_t TimeSeriesStore::addSeries(const std::string& name, const std::vector<std::string>& fields, const std::vector<int32_t>& scales) {
+    if (fields.empty() || fields.size() > TIMESERIES_MAX_VALUES || scales.size() != fields.size()) {
+        throw std::runtime_error("time series " + name + ": 1 to 16 fields with one scale each");
+    }
+    if (name.size() > UINT8_MAX || series.size() > UINT16_MAX) throw std::runtime_error("time series " + name + ": name too long or too many series");
+    for (size_t i = 0; i < fields.size(); i++) {
+        if (fields[i].size() > UINT8_MAX || scales[i] <= 0) throw std::runtime_error("time series " + name + ": bad field " + fields[i]);
+    }
+
+    series.push_back({name, fields, scales, {}, INT64_MIN});
+    series.back().block.reset(fields.size());
+    return static_cast<uint16_t>(series.size() - 1);
+}
+
+//--> Compress the sample into the open block of its series
+void TimeSeriesStore::append(uint16_t id, int64_t timestampUs, const float* values) {
+    if (id >= series.size()) return;
+    Series& s = series[id];
+
+    //--> A sample in a later partition closes the blocks of the current one
+    int64_t partition = timestampUs / partitionUs * partitionUs;
+    if (timestampUs < 0 && partition != timestampUs) partition -= partitionUs;
+    if (partition > currentPartition) {
+        closeAll();
+        currentPartition = partition;
+    }
+
+    int64_t fixed[TIMESERIES_MAX_VALUES];
+    for (size_t i = 0; i < s.fields.size(); i++) fixed[i] = toFixed(values[i], s.scales[i]);
+    s.block.add(timestampUs, fixed);
+    samples++;
+    rawBytes += 8 + 4 * s.fields.size();
+
+    if (s.block.bytes().size() >= options.blockSize || s.block.count() >= TS_MAX_BLOCK) closeBlock(id);
+
+    //--> Hand over on size or age
+    if (fillingBytes >= options.writeSize ||
+        monotonicNs() - lastHandOverNs >= std::chrono::duration_cast<std::chrono::nanoseconds>(options.flushInterval).count()) {
+        closeAll();
+        handOver();
+    }
+}
+
+//--> Write everything and wait for the writer
+void TimeSeriesStore::flush() {
+    closeAll();
+    handOver();
+    std::unique_lock<std::mutex> guard(lock);
+    changed.wait(guard, [this] { return queued.empty() && !writing; });
+}
+
+//--> Current counters, the writer ones under the lock
+TimeSeriesMetrics TimeSeriesStore::metrics() {
+    std::lock_guard<std::mutex> guard(lock);
+    TimeSeriesMetrics m = stats;
+    m.samples = samples;
+    m.dropped = dropped;
+    m.blocks = blocks;
+    m.rawBytes = rawBytes;
+    return m;
+}
+
+//--> Records for the current partition
+std::vector<uint8_t>& TimeSeriesStore::chunk() {
+    if (filling.empty() || filling.back().partitionUs != currentPartition) filling.push_back({currentPartition, {}});
+    return filling.back().data;
+}
+
+//--> Turn the open block of a series into a record, with the series definition first when the segment lacks it
+void TimeSeriesStore::closeBlock(uint16_t id) {
+    Series& s = series[id];
+    if (s.block.count() == 0) return;
+    std::vector<uint8_t>& out = chunk();
+    size_t before = out.size();
+
+    if (s.definedIn != currentPartition) {
+        size_t start = beginRecord(out, TS_KIND_SERIES);
+        put<uint16_t>(out, id);
+        put<uint8_t>(out, static_cast<uint8_t>(s.fields.size()));
+        put<uint8_t>(out, static_cast<uint8_t>(s.name.size()));
+        out.insert(out.end(), s.name.begin(), s.name.end());
+        for (size_t i = 0; i < s.fields.size(); i++) {
+            put<uint8_t>(out, static_cast<uint8_t>(s.fields[i].size()));
+            out.insert(out.end(), s.fields[i].begin(), s.fields[i].end());
+            put<int32_t>(out, s.scales[i]);
+        }
+        endRecord(out, start);
+        s.definedIn = currentPartition;
+    }
+
+    size_t start = beginRecord(out, TS_KIND_SUMMARY);
+    put<uint16_t>(out, id);
+    put<uint16_t>(out, static_cast<uint16_t>(s.block.count()));
+    put<int64_t>(out, s.block.firstTimestamp());
+    put<int64_t>(out, s.block.lastTimestamp());
+    for (size_t i = 0; i < s.fields.size(); i++) {
+        const SeriesSummary& summary = s.block.summary(i);
+        putVarint(out, summary.count);
+        putVarint(out, zigzagEncode(summary.min));
+        putVarint(out, zigzagEncode(summary.max));
+        putVarint(out, zigzagEncode(summary.sum));
+    }
+    out.insert(out.end(), s.block.bytes().begin(), s.block.bytes().end());
+    endRecord(out, start);
+
+    fillingBytes += out.size() - before;
+    fillingSamples += s.block.count();
+    filling.back().samples += s.block.count();
+    blocks++;
+    s.block.reset(s.fields.size());
+}
+
+//--> Close the open block of every series
+void TimeSeriesStore::closeAll() {
+    for (size_t id = 0; id < series.size(); id++) closeBlock(static_cast<uint16_t>(id));
+}
+
+//--> Move the closed blocks to the writer without waiting, past maxQueued they are dropped
+void TimeSeriesStore::handOver() {
+    lastHandOverNs = monotonicNs();
+    if (filling.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (queuedBytes + fillingBytes > options.maxQueued) {
+            dropped += fillingSamples;
+            redefine = true;
+        } else {
+            for (Chunk& c : filling) {
+                if (!queued.empty() && queued.back().partitionUs == c.partitionUs) {
+                    queued.back().data.insert(queued.back().data.end(), c.data.begin(), c.data.end());
+                    queued.back().samples += c.samples;
+                } else {
+                    queued.push_back(std::move(c));
+                }
+            }
+            queuedBytes += fillingBytes;
+        }
+    }
+    filling.clear();
+    fillingBytes = 0;
+    fillingSamples = 0;
+
+    //--> The dropped records may have held series definitions, the next blocks write them again
+    if (redefine) {
+        for (Series& s : series) s.definedIn = INT64_MIN;
+        redefine = false;
+    }
+    changed.notify_all();
+}
+
+//--> Writer thread, one write and one sync per partition per cycle
+void TimeSeriesStore::run() {
+    std::vector<Chunk> work;
+    std::unique_lock<std::mutex> guard(lock);
+    while (true) {
+        changed.wait(guard, [this] { return !queued.empty() || !running; });
+        if (queued.empty()) break;
+        work.swap(queued);
+        queuedBytes = 0;
+        writing = true;
+        guard.unlock();
+
+        int64_t start = monotonicNs();
+        uint64_t written = 0, lost = 0;
+        for (Chunk& c : work) {
+            remember(c.data);
+            if ((c.partitionUs != openPartition || fd < 0) && !openSegment(c.partitionUs)) {
+                lost += c.samples;
+                lostDefinitions = true;
+                continue;
+            }
+
+            //--> Records were lost before this chunk, the blocks in it may refer to definitions that were in them
+            if (lostDefinitions) {
+                std::vector<uint8_t> records;
+                for (const auto& d : definitions) records.insert(records.end(), d.second.begin(), d.second.end());
+                c.data.insert(c.data.begin(), records.begin(), records.end());
+                lostDefinitions = false;
+            }
+
+            off_t end = lseek(fd, 0, SEEK_CUR);
+            ssize_t n = ::write(fd, c.data.data(), c.data.size());
+            if (n != static_cast<ssize_t>(c.data.size())) {
+                //--> Disk full or failing: cut the torn record off so the records written after it stay readable
+                std::perror("time series write");
+                if (n > 0 && ftruncate(fd, end) != 0) std::perror("time series truncate");
+                lseek(fd, end, SEEK_SET);
+                lost += c.samples;
+                lostDefinitions = true;
+                continue;
+            }
+            fdatasync(fd);
+            written += c.data.size();
+        }
+        int64_t tookUs = (monotonicNs() - start) / 1000;
+        work.clear();
+
+        guard.lock();
+        writing = false;
+        dropped += lost;
+        stats.writes++;
+        stats.bytes += written;
+        stats.lastWriteUs = tookUs;
+        stats.maxWriteUs = std::max(stats.maxWriteUs, tookUs);
+        changed.notify_all();
+    }
+}
+
+//--> Keep the latest definition record of every series in a chunk, to write them again after lost records
+void TimeSeriesStore::remember(const std::vector<uint8_t>& data) {
+    size_t at = 0;
+    while (at + TS_RECORD_HEAD + 3 <= data.size()) {
+        size_t length = getU32(data.data() + at);
+        const uint8_t* record = data.data() + at + TS_RECORD_HEAD;
+        if (record[0] == TS_KIND_SERIES) {
+            uint16_t id = static_cast<uint16_t>(record[1] | record[2] << 8);
+            definitions[id].assign(data.begin() + at, data.begin() + at + TS_RECORD_HEAD + length);
+        }
+        at += TS_RECORD_HEAD + length;
+    }
+}
+
+//--> Open the segment of a partition for appending, a new one gets its header, an old one loses its torn tail
+bool TimeSeriesStore::openSegment(int64_t partition) {
+    if (fd >= 0) close(fd);
+    fd = -1;
+    openPartition = partition;
+
+    //--> The segments before this partition are finished (or left behind by an earlier run), index them once
+    size_t sealed = sealTimeSeriesSegments(options.directory, partition);
+    if (sealed > 0) {
+        std::lock_guard<std::mutex> guard(lock);
+        stats.sealed += sealed;
+    }
+
+    std::string path = timeSeriesSegmentPath(options.directory, partition);
+
+    int file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        std::perror(("cannot open time series segment " + path).c_str());
+        return false;
+    }
+    struct stat info;
+    fstat(file, &info);
+    size_t size = static_cast<size_t>(info.st_size);
+
+    //--> Walk the records, the first bad length or crc is where a power cut tore the file
+    size_t valid = 0;
+    uint8_t header[TS_HEADER_SIZE];
+    if (size >= TS_HEADER_SIZE && pread(file, header, TS_HEADER_SIZE, 0) == TS_HEADER_SIZE) {
+        if (std::memcmp(header, TS_MAGIC, 8) != 0) {
+            std::fprintf(stderr, "time series segment %s is not a segment, not writing to it\n", path.c_str());
+            close(file);
+            return false;
+        }
+        valid = TS_HEADER_SIZE;
+        std::vector<uint8_t> record;
+        uint8_t head[TS_RECORD_HEAD];
+        while (valid + TS_RECORD_HEAD <= size && pread(file, head, TS_RECORD_HEAD, valid) == TS_RECORD_HEAD) {
+            size_t length = getU32(head);
+            if (length == 0 || valid + TS_RECORD_HEAD + length > size) break;
+            record.resize(length);
+            if (pread(file, record.data(), length, valid + TS_RECORD_HEAD) != static_cast<ssize_t>(length)) break;
+            if (crc32(record.data(), length) != getU32(head + 4)) break;
+            valid += TS_RECORD_HEAD + length;
+        }
+    }
+
+    bool created = valid == 0;
+    if (valid != size) {
+        if (ftruncate(file, static_cast<off_t>(valid)) != 0) std::perror("time series truncate");
+        if (!created) {
+            std::lock_guard<std::mutex> guard(lock);
+            stats.truncated += size - valid;
+        }
+    }
+    lseek(file, 0, SEEK_END);
+
+    if (created) {
+        uint8_t head[TS_HEADER_SIZE];
+        std::memcpy(head, TS_MAGIC, 8);
+        for (int i = 0; i < 8; i++) head[8 + i] = static_cast<uint8_t>(static_cast<uint64_t>(partition) >> (8 * i));
+        if (::write(file, head, TS_HEADER_SIZE) != TS_HEADER_SIZE) std::perror("time series header");
+
+        //--> The new name has to survive a power cut too
+        int dirFd = open(options.directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dirFd >= 0) {
+            fsync(dirFd);
+            close(dirFd);
+        }
+    }
+
+    fd = file;
+    std::lock_guard<std::mutex> guard(lock);
+    stats.segments++;
+    return true;
+}
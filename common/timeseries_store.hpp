@@ -0,0 +1,180 @@
+/*!
+ * \file      timeseries_store.hpp
+ * \brief     Local compressed time-series store in time-partitioned, append-only segment files
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Every series (one sensor) collects its samples in an open block,
+ * compressed as they come in (timeseries_codec.hpp). A block is closed when
+ * it reaches blockSize bytes, and all open blocks are closed every
+ * flushInterval. Closed blocks go to a writer thread that appends them to
+ * the segment file of their partition with one write() and one fdatasync(),
+ * so the sample loop never waits for the SD card.
+ *
+ * One segment file per partition (default one UTC day), named after its
+ * start: ts-20261018T0000.seg. A segment starts with the 8 byte magic
+ * "TSSEG001" and the i64 partition start in unix us, followed by records:
+ *
+ *   u32 length of the rest | u32 crc32 of the rest | u8 kind | ...
+ *
+ *   kind 1 series  u16 id | u8 values | u8 name length | name | per value: u8 length | name | i32 scale
+ *   kind 3 block   u16 id | u16 samples | i64 first us | i64 last us
+ *                  per value: count | min | max | sum (varints, zig-zag but the count) | compressed samples
+ *
+ * (kind 2 is the same block without the summaries, as written before they
+ * existed; readers still take it.)
+ * integers little-endian. A series is defined in a segment before its first
+ * block, a later definition of the same id replaces it (a new run may number
+ * the series differently). Samples with a timestamp before the current
+ * partition (clock stepped back) stay in the current segment.
+ *
+ * Crash safety: files are only appended to, never rewritten. A record torn
+ * by a power cut fails its crc; when the segment is opened again for
+ * writing it is cut off there, readers stop there. At most the last
+ * flushInterval of samples is lost. A short write (disk full) is cut off
+ * straight away. When records are lost (dropped past maxQueued, a failed
+ * write or open) the series definitions are written again before the next
+ * blocks, so those stay readable.
+ *
+ * SD card wear: at 1 Hz a BME280 sample takes about 5 bytes, a day of 40
+ * sensors is about 17 MB written in a few hundred large appends, instead of
+ * hundreds of thousands of small writes that each rewrite a flash page.
+ *
+ * Queries: when the writer opens the segment of a new partition it writes
+ * the sparse index of the finished ones next to them (ts-...idx, see
+ * timeseries_index.hpp), TimeSeriesReader (timeseries_reader.hpp) uses it.
+ *
+ */
+
+#ifndef TIMESERIES_STORE_HPP
+#define TIMESERIES_STORE_HPP
+
+#include "timeseries_codec.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//--> Store settings
+struct TimeSeriesOptions {
+    std::string directory = "store";
+    std::chrono::hours partition{24};               // time covered by one segment file
+    size_t blockSize = 4096;                        // compressed bytes after which a block is closed
+    std::chrono::seconds flushInterval{300};        // blocks are written at least this often
+    size_t writeSize = 64 * 1024;                   // or as soon as this many bytes wait
+    size_t maxQueued = 4 * 1024 * 1024;             // bytes waiting for a slow or broken disk before samples are dropped
+};
+
+//--> Store counters
+struct TimeSeriesMetrics {
+    uint64_t samples;           // samples appended
+    uint64_t dropped;           // samples lost: the writer fell maxQueued behind, or a segment open or write failed
+    uint64_t blocks;            // blocks closed
+    uint64_t rawBytes;          // size of the samples uncompressed (8 byte time + 4 per value)
+    uint64_t writes;            // write + sync cycles
+    uint64_t bytes;             // bytes written, headers included
+    uint64_t segments;          // segment files opened for writing
+    uint64_t truncated;         // torn bytes cut off when reopening a segment
+    uint64_t sealed;            // index files written for finished segments
+    int64_t lastWriteUs;        // write + sync time of the last cycle
+    int64_t maxWriteUs;
+};
+
+//--> Append-only store, one producer thread
+class TimeSeriesStore {
+
+//-> Public functions
+public:
+    //--> Constructor, creates the directory and starts the writer thread (throws std::runtime_error)
+    explicit TimeSeriesStore(const TimeSeriesOptions& options);
+
+    //--> Destructor, writes everything that waits
+    ~TimeSeriesStore();
+
+    TimeSeriesStore(const TimeSeriesStore&) = delete;
+    TimeSeriesStore& operator=(const TimeSeriesStore&) = delete;
+
+    //--> Add a series, one fixed point scale per value (100 = 0.01 steps), returns its id (throws std::runtime_error)
+    uint16_t addSeries(const std::string& name, const std::vector<std::string>& fields, const std::vector<int32_t>& scales);
+
+    //--> Store one sample, one value per field, in time order per series, does not wait for the disk
+    void append(uint16_t series, int64_t timestampUs, const float* values);
+
+    //--> Close all blocks, write them and wait until they are synced
+    void flush();
+
+    //--> Current counters, call from the thread that appends
+    TimeSeriesMetrics metrics();
+
+//-> Private functions and variables
+private:
+    //--> One series and its open block
+    struct Series {
+        std::string name;
+        std::vector<std::string> fields;
+        std::vector<int32_t> scales;
+        SeriesBlockEncoder block;
+        int64_t definedIn = INT64_MIN;      // partition whose segment already has the definition
+    };
+
+    //--> Records for the segment of one partition
+    struct Chunk {
+        int64_t partitionUs;
+        std::vector<uint8_t> data;
+        uint64_t samples = 0;               // in the blocks of data, counted as dropped when it is not written
+    };
+
+    TimeSeriesOptions options;
+    int64_t partitionUs;
+
+    //--> Producer side
+    std::vector<Series> series;
+    int64_t currentPartition = INT64_MIN;
+    std::vector<Chunk> filling;
+    size_t fillingBytes = 0;
+    uint64_t fillingSamples = 0;
+    int64_t lastHandOverNs;
+    uint64_t samples = 0;
+    uint64_t dropped = 0;
+    uint64_t blocks = 0;
+    uint64_t rawBytes = 0;
+    bool redefine = false;              // a hand-over was dropped, write the series definitions again
+
+    //--> Shared with the writer
+    std::mutex lock;
+    std::condition_variable changed;
+    std::vector<Chunk> queued;
+    size_t queuedBytes = 0;
+    bool writing = false;
+    bool running = true;
+    TimeSeriesMetrics stats{};          // writer counters
+
+    //--> Writer side
+    std::thread writer;
+    int fd = -1;
+    int64_t openPartition = INT64_MIN;
+    std::map<uint16_t, std::vector<uint8_t>> definitions;     // latest definition record per series id
+    bool lostDefinitions = false;       // records were lost, write the definitions before the next chunk
+
+    //--> Producer helpers
+    void closeBlock(uint16_t id);
+    void closeAll();
+    std::vector<uint8_t>& chunk();
+    void handOver();
+
+    //--> Writer helpers
+    void run();
+    void remember(const std::vector<uint8_t>& data);
+    bool openSegment(int64_t partition);
+};
+
+//--> Path of the segment of a partition
+std::string timeSeriesSegmentPath(const std::string& directory, int64_t partitionUs);
+
+#endif //--> TIMESERIES_STORE_HPP
@@ -0,0 +1,68 @@
+/*!
+ * \file      topic_aliases.cpp
+ * \brief     MQTT v5 topic aliases and once-per-connection metadata
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ */
+
+#include "topic_aliases.hpp"
+
+//--> Register a topic
+void TopicAliases::addTopic(const std::string& topic, TopicMetadata metadata) {
+    std::lock_guard<std::mutex> guard(lock);
+    topics[topic].metadata = std::move(metadata);
+}
+
+//--> Start over for a new connection
+void TopicAliases::reset(int max) {
+    std::lock_guard<std::mutex> guard(lock);
+    maxAlias = max;
+    nextAlias = 1;
+    for (auto& entry : topics) {
+        entry.second.alias = 0;
+        entry.second.announced = false;
+    }
+}
+
+//--> Add alias and metadata properties, drop the topic when the broker already knows the alias
+mqtt::const_message_ptr TopicAliases::apply(const mqtt::const_message_ptr& msg) {
+    std::lock_guard<std::mutex> guard(lock);
+
+    auto it = topics.find(msg->get_topic());
+    if (it == topics.end()) return msg;
+    Entry& entry = it->second;
+
+    //--> Hand out aliases in order of first use, as long as the broker allows more
+    if (entry.alias == 0 && nextAlias <= maxAlias) entry.alias = nextAlias++;
+
+    //--> Nothing to add after the first message when there is no alias
+    if (entry.alias == 0 && entry.announced) return msg;
+
+    mqtt::properties props;
+    if (entry.alias) props.add(mqtt::property(mqtt::property::TOPIC_ALIAS, entry.alias));
+    if (!entry.announced) {
+        for (const auto& meta : entry.metadata) props.add(mqtt::property(mqtt::property::USER_PROPERTY, meta.first, meta.second));
+    }
+
+    bool shorten = entry.alias && entry.announced && msg->get_qos() == 0;
+    auto wire = mqtt::make_message(shorten ? std::string() : msg->get_topic(), msg->get_payload_str());
+    wire->set_qos(msg->get_qos());
+    wire->set_retained(msg->is_retained());
+    wire->set_properties(props);
+
+    if (shorten) {
+        stats.shortened++;
+        stats.bytesSaved += msg->get_topic().size();
+    } else {
+        stats.full++;
+    }
+    entry.announced = true;
+    return wire;
+}
+
+//--> Copy of the counters
+TopicAliasMetrics TopicAliases::metrics() {
+    std::lock_guard<std::mutex> guard(lock);
+    return stats;
+}
@@ -0,0 +1,76 @@
+/*!
+ * \file      topic_aliases.hpp
+ * \brief     MQTT v5 topic aliases and once-per-connection metadata
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * With MQTT v5 a topic can be replaced by a 2 byte alias. The first message
+ * on a topic after a connect carries the full topic plus the alias, the ones
+ * after it only the alias. The same first message carries the metadata of
+ * the topic (units, schema version) as user properties, so consumers keep it
+ * per topic instead of finding it in every payload.
+ *
+ * Aliases only live as long as the connection: call reset() on every connect
+ * with the alias maximum from the CONNACK, and reset(0) when the connection
+ * drops so nothing is shortened before the new CONNACK is seen. Paho sends
+ * QoS1/2 messages again after a reconnect exactly as they were, an alias-only
+ * message would then point at an alias the new connection does not know.
+ * So only QoS0 messages are shortened, QoS1/2 ones keep the full topic.
+ *
+ */
+
+#ifndef TOPIC_ALIASES_HPP
+#define TOPIC_ALIASES_HPP
+
+#include <mqtt/async_client.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+//--> User properties of a topic, name and value
+using TopicMetadata = std::vector<std::pair<std::string, std::string>>;
+
+//--> Alias counters
+struct TopicAliasMetrics {
+    uint64_t shortened;         // messages sent with the alias only
+    uint64_t full;              // messages of an aliased topic sent with the full topic
+    uint64_t bytesSaved;        // topic bytes not sent
+};
+
+//--> Alias table of one connection
+class TopicAliases {
+
+//-> Public functions
+public:
+    //--> Give this topic an alias (when the broker allows one) and send the metadata with its first message
+    void addTopic(const std::string& topic, TopicMetadata metadata = {});
+
+    //--> New connection, forget all aliases, maxAlias is TOPIC_ALIAS_MAXIMUM of the broker (0 = none)
+    void reset(int maxAlias);
+
+    //--> Message as it should go on the wire, msg itself is never changed
+    mqtt::const_message_ptr apply(const mqtt::const_message_ptr& msg);
+
+    //--> Current counters
+    TopicAliasMetrics metrics();
+
+//-> Private functions and variables
+private:
+    struct Entry {
+        TopicMetadata metadata;
+        int alias = 0;              // 0 = no alias on this connection
+        bool announced = false;     // full topic (and metadata) sent on this connection
+    };
+
+    std::mutex lock;
+    std::map<std::string, Entry> topics;
+    int maxAlias = 0;
+    int nextAlias = 1;
+    TopicAliasMetrics stats{};
+};
+
+#endif //--> TOPIC_ALIASES_HPP
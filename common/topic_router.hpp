@@ -0,0 +1,88 @@
+/*!
+ * \file      topic_router.hpp
+ * \brief     Compile-time perfect hash from topic names to handler indexes
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * The topic list is a constexpr array of names. At compile time a seed is
+ * searched for which FNV-1a gives every name its own slot in a power of two
+ * table, so a lookup at run time is one hash over the topic, one table read
+ * and one compare to reject unknown topics. No strings are built.
+ *
+ * Usage:
+ *   inline constexpr std::string_view COMMANDS[] = { "heartbeat", "bloodoxygen" };
+ *   int index = TopicRouter<COMMANDS>::find("heartbeat");     // 0, or -1 when unknown
+ *
+ */
+
+#ifndef TOPIC_ROUTER_HPP
+#define TOPIC_ROUTER_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+
+//--> Perfect hash table for a fixed topic list
+template <const auto& Topics>
+struct TopicRouter {
+    static constexpr size_t count = std::size(Topics);
+
+    //--> Table size, power of two with at least twice the topics so a seed is found quickly
+    static constexpr size_t tableSize() {
+        size_t n = 1;
+        while (n < 2 * count) n <<= 1;
+        return n;
+    }
+    static constexpr size_t size = tableSize();
+
+    //--> FNV-1a with a seed mixed into the offset basis
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t h = 2166136261u ^ seed;
+        for (char c : key) {
+            h ^= static_cast<uint8_t>(c);
+            h *= 16777619u;
+        }
+        return h ^ (h >> 15);
+    }
+
+    struct Table {
+        bool found = false;
+        uint32_t seed = 0;
+        std::array<int16_t, size> slots{};      // topic index per slot, -1 = empty
+    };
+
+    //--> Try seeds until no two topics share a slot
+    static constexpr Table build() {
+        for (uint32_t seed = 0; seed < 100000; seed++) {
+            Table t{};
+            t.seed = seed;
+            for (auto& slot : t.slots) slot = -1;
+
+            bool collision = false;
+            for (size_t i = 0; i < count && !collision; i++) {
+                size_t slot = hash(Topics[i], seed) & (size - 1);
+                if (t.slots[slot] >= 0) collision = true;
+                else t.slots[slot] = static_cast<int16_t>(i);
+            }
+            if (!collision) {
+                t.found = true;
+                return t;
+            }
+        }
+        return Table{};
+    }
+
+    static constexpr Table table = build();
+    static_assert(table.found, "no perfect hash seed found, are there duplicate topics?");
+
+    //--> Index of the topic in the list, -1 when it is not in it
+    static constexpr int find(std::string_view topic) {
+        int index = table.slots[hash(topic, table.seed) & (size - 1)];
+        return index >= 0 && Topics[index] == topic ? index : -1;
+    }
+};
+
+#endif //--> TOPIC_ROUTER_HPP
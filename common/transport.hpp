@@ -0,0 +1,53 @@
+/*!
+ * \file      transport.hpp
+ * \brief     Messaging transport interface, the application does not see which one is used
+ * \author    Wietse Houwers
+ * \date      October 2026
+ *
+ * \details
+ * Two implementations:
+ *
+ *   PahoTransport       mqtt::async_client with the ConnectionManager, the real broker
+ *   LoopbackTransport   lock-free queue to subscribers in the same process, no network
+ *
+ * The loopback lets the whole program run in a test or benchmark without a
+ * broker, and measures formatting and pipeline overhead on their own.
+ *
+ */
+
+#ifndef TRANSPORT_HPP
+#define TRANSPORT_HPP
+
+#include "connection_state.hpp"
+#include <functional>
+#include <string>
+#include <string_view>
+
+//--> Publish and subscribe, one instance per connection
+class Transport {
+
+//-> Public functions
+public:
+    //--> Incoming message, called on the transport thread
+    using MessageHandler = std::function<void(std::string_view topic, std::string_view payload)>;
+
+    virtual ~Transport() = default;
+
+    //--> Receive messages for this filter (may use + and #), call before start()
+    virtual void subscribe(const std::string& filter, int qos) = 0;
+
+    //--> Where messages for the subscriptions go, call before start()
+    virtual void setMessageHandler(MessageHandler handler) = 0;
+
+    //--> Start and stop delivering
+    virtual void start() = 0;
+    virtual void stop() = 0;
+
+    //--> Connection state, publish() only makes sense when Connected
+    virtual ConnectionState state() const = 0;
+
+    //--> Send one message, false when it was not taken
+    virtual bool publish(const std::string& topic, std::string payload, int qos) = 0;
+};
+
+#endif //--> TRANSPORT_HPP